@@ -0,0 +1,840 @@
+/// @file bench.cpp
+/// @author Mark Bundschuh
+/// @brief Microbenchmarks of the hot paths of the game, reported as JSON
+///
+/// Built and run with `make bench`. Every benchmark is run for a number of
+/// samples, each repeating the operation enough times to take at least
+/// MIN_SAMPLE_TIME, and reports the median, fastest and slowest time per
+/// operation along with heap allocations per operation. Pass substrings of
+/// benchmark names as arguments to only run the matching benchmarks.
+///
+/// `bench.out --check` (or `make check`) instead runs every SIMD kernel and
+/// its scalar version on the same random inputs and fails if they differ.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FEHLCD.h"
+
+#include "../blit.h"
+#include "../config.h"
+#include "../entities.h"
+#include "../framebuffer.h"
+#include "../game.h"
+#include "../grid.h"
+#include "../image.h"
+#include "../integrate.h"
+#include "../knife.h"
+#include "../menu.h"
+#include "../particles.h"
+#include "../sweep.h"
+#include "../throwable.h"
+#include "../ui.h"
+#include "../util.h"
+
+// the replacements below pair malloc with free correctly, but gcc only sees
+// free being called on memory from operator new
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+/// Number of heap allocations made so far, counted by the operator new
+/// replacements below
+static uint64_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocations++;
+    size_t align = (size_t)alignment;
+    size = (size + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, size ? size : align))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+/// Keep the compiler from optimizing away a value which is never used
+/// @param value value to keep
+template <typename T>
+void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// Runs benchmarks and collects their results as JSON
+class Bench {
+   public:
+    /// Parameters of a benchmark, as names and JSON values
+    using Params = std::vector<std::pair<std::string, std::string>>;
+
+    /// How a benchmark is run
+    struct Options {
+        /// Number of items each operation processes, to report time per item
+        size_t items = 1;
+        /// Limit on operations per sample, for benchmarks where state drifts
+        /// as operations are repeated
+        size_t max_iterations = SIZE_MAX;
+        /// Run before every sample, outside of the timed region
+        std::function<void()> setup;
+    };
+
+    /// Create a runner
+    /// @param filters only run benchmarks whose name contains one of these,
+    /// or everything if empty
+    Bench(std::vector<std::string> filters) : filters(std::move(filters)) {}
+
+    /// Time an operation and record the result
+    /// @param name name of the benchmark
+    /// @param params parameters which distinguish this run of the benchmark
+    /// @param op operation to time
+    /// @param options how to run the benchmark
+    void run(const std::string& name,
+             const Params& params,
+             const std::function<void()>& op,
+             const Options& options);
+
+    /// Time an operation with the default options and record the result
+    /// @param name name of the benchmark
+    /// @param params parameters which distinguish this run of the benchmark
+    /// @param op operation to time
+    void run(const std::string& name,
+             const Params& params,
+             const std::function<void()>& op) {
+        run(name, params, op, Options());
+    }
+
+    /// Write every result as a JSON document
+    /// @param out stream to write to
+    void report(std::ostream& out) const;
+
+    /// Quote a string for JSON
+    /// @param s string without control characters
+    static std::string string(const std::string& s) { return "\"" + s + "\""; }
+
+   private:
+    /// Minimum time each sample runs the operation for
+    static constexpr double MIN_SAMPLE_TIME = 0.02;
+    /// Number of samples of each benchmark
+    static const int SAMPLES = 15;
+
+    /// Time repeating an operation
+    /// @param op operation to time
+    /// @param iterations number of times to run the operation
+    /// @return seconds taken
+    static double time(const std::function<void()>& op, size_t iterations);
+
+    std::vector<std::string> filters;
+    std::vector<std::string> results;
+};
+
+double Bench::time(const std::function<void()>& op, size_t iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+        op();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void Bench::run(const std::string& name,
+                const Params& params,
+                const std::function<void()>& op,
+                const Options& options) {
+    if (!filters.empty() &&
+        std::none_of(filters.begin(), filters.end(), [&](auto& filter) {
+            return name.find(filter) != std::string::npos;
+        }))
+        return;
+
+    // double the iterations until a sample is long enough to time reliably
+    if (options.setup)
+        options.setup();
+    size_t iterations = 1;
+    while (iterations < options.max_iterations &&
+           time(op, iterations) < MIN_SAMPLE_TIME) {
+        iterations = std::min(iterations * 2, options.max_iterations);
+        if (options.setup)
+            options.setup();
+    }
+
+    std::vector<double> ns;
+    uint64_t allocated = 0;
+    for (int i = 0; i < SAMPLES; i++) {
+        if (options.setup)
+            options.setup();
+        uint64_t before = allocations;
+        ns.push_back(time(op, iterations) * 1e9 / iterations);
+        allocated += allocations - before;
+    }
+    std::sort(ns.begin(), ns.end());
+    double median = ns[ns.size() / 2];
+
+    std::string json = "{\"name\": " + string(name) + ", \"params\": {";
+    for (size_t i = 0; i < params.size(); i++) {
+        json += (i ? ", " : "") + string(params[i].first) + ": " +
+                params[i].second;
+    }
+
+    char numbers[256];
+    std::snprintf(numbers, sizeof(numbers),
+                  "}, \"iterations\": %zu, \"samples\": %d, "
+                  "\"ns_per_op\": {\"median\": %.1f, \"min\": %.1f, "
+                  "\"max\": %.1f}, \"items\": %zu, \"ns_per_item\": %.2f, "
+                  "\"allocs_per_op\": %.2f}",
+                  iterations, SAMPLES, median, ns.front(), ns.back(),
+                  options.items, median / options.items,
+                  (double)allocated / (SAMPLES * iterations));
+    json += numbers;
+    results.push_back(json);
+
+    std::cerr << name;
+    for (auto& [key, value] : params)
+        std::cerr << " " << key << "=" << value;
+    std::cerr << ": " << median << " ns/op" << std::endl;
+}
+
+void Bench::report(std::ostream& out) const {
+    out << "{\"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+        out << "  " << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+    out << "]}\n";
+}
+
+/// Make a sprite shaped like the game's: an opaque disc with noisy colors and
+/// transparent corners
+/// @param size width and height in pixels
+static Image make_sprite(int size) {
+    PixelBuffer pixels((size_t)size * size);
+    float r = size / 2.0f;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            float dx = x + 0.5f - r, dy = y + 0.5f - r;
+            bool inside = dx * dx + dy * dy <= r * r;
+            pixels[(size_t)y * size + x] =
+                inside ? 0xff000000 | (uint32_t)(rand() & 0xffffff) : 0;
+        }
+    }
+    return Image(size, size, std::move(pixels));
+}
+
+static void bench_image_render(Bench& bench) {
+    for (int size : {16, 32, 64, 128}) {
+        Image sprite = make_sprite(size);
+        Bench::Params params = {{"size", std::to_string(size)}};
+        int x = LCD_WIDTH / 2, y = LCD_HEIGHT / 2;
+        float theta = 0.3f;
+
+        auto with = [&](const char* rotation) {
+            Bench::Params p = params;
+            p.push_back({"rotation", Bench::string(rotation)});
+            return p;
+        };
+
+        bench.run("image_render", with("none"),
+                  [&] { sprite.render(x, y, 0); });
+        bench.run("image_render", with("nearest"),
+                  [&] { sprite.render(x, y, theta); });
+        bench.run("image_render", with("rotsprite_cached"), [&] {
+            image_repository->rotated(sprite, theta).render(x, y, 0);
+        });
+        image_repository->clear_rotations();
+    }
+}
+
+static void bench_collide_line_circle(Bench& bench) {
+    // a mix of hits and misses, with segments starting inside, crossing, and
+    // passing by circles
+    const size_t CASES = 1024;
+    std::vector<Vector2> starts, ends, centers;
+    for (size_t i = 0; i < CASES; i++) {
+        starts.push_back({rand_range(0, LCD_WIDTH), rand_range(0, LCD_HEIGHT)});
+        ends.push_back(starts.back() +
+                       Vector2(rand_range(-40, 40), rand_range(-40, 40)));
+        centers.push_back(starts.back() +
+                          Vector2(rand_range(-30, 30), rand_range(-30, 30)));
+    }
+
+    size_t i = 0;
+    bench.run("collide_line_circle", {}, [&] {
+        do_not_optimize(
+            collide_line_circle(starts[i], ends[i], centers[i], 13));
+        i = (i + 1) % CASES;
+    });
+
+    // one segment against a packed batch of circles, as the knife does
+    std::vector<float> xs, ys, radii;
+    for (const Vector2& center : centers) {
+        xs.push_back(center.x);
+        ys.push_back(center.y);
+        radii.push_back(13);
+    }
+    std::vector<uint64_t> hits((CASES + 63) / 64);
+    for (size_t n : {16, 256, 1024}) {
+        Bench::Options options;
+        options.items = n;
+        bench.run("collide_line_circles", {{"circles", std::to_string(n)}},
+                  [&] {
+                      collide_line_circles(starts[0], ends[0], xs.data(),
+                                           ys.data(), radii.data(), n,
+                                           hits.data());
+                      do_not_optimize(hits[0]);
+                  },
+                  options);
+    }
+
+    // the knife over a physics step against circles each moving a few pixels,
+    // as the game cuts
+    std::vector<float> xs2, ys2;
+    for (size_t i = 0; i < CASES; i++) {
+        xs2.push_back(xs[i] + rand_range(-4, 4));
+        ys2.push_back(ys[i] + rand_range(-4, 4));
+    }
+    for (size_t n : {16, 256, 1024}) {
+        Bench::Options options;
+        options.items = n;
+        bench.run("collide_swept_circles", {{"circles", std::to_string(n)}},
+                  [&] {
+                      collide_swept_circles(starts[0], ends[0], xs.data(),
+                                            ys.data(), xs2.data(), ys2.data(),
+                                            radii.data(), n, hits.data());
+                      do_not_optimize(hits[0]);
+                  },
+                  options);
+    }
+}
+
+static void bench_sprite_segment_hits(Bench& bench) {
+    // knife paths through the pineapple's bounding circle, most of which the
+    // circle test alone would count as hits
+    const Image& image = image_repository->sprite(SpriteId::Pineapple);
+    const size_t CASES = 1024;
+    std::vector<Vector2> starts, ends;
+    for (size_t i = 0; i < CASES; i++) {
+        starts.push_back({rand_range(-20, 20), rand_range(-20, 20)});
+        ends.push_back(starts.back() +
+                       Vector2(rand_range(-10, 10), rand_range(-10, 10)));
+    }
+
+    for (float theta : {0.0f, 0.7f}) {
+        size_t i = 0;
+        bench.run("sprite_segment_hits",
+                  {{"rotated", theta != 0 ? "true" : "false"}},
+                  [&] {
+                      do_not_optimize(
+                          image.segment_hits(starts[i], ends[i], theta));
+                      i = (i + 1) % CASES;
+                  });
+    }
+}
+
+static void bench_circles(Bench& bench) {
+    for (int r : {3, 10, 50}) {
+        Bench::Params params = {{"radius", std::to_string(r)}};
+        bench.run("fill_circle", params, [&] {
+            fill_circle(LCD_WIDTH / 2, LCD_HEIGHT / 2, r);
+        });
+        bench.run("draw_circle", params, [&] {
+            draw_circle(LCD_WIDTH / 2, LCD_HEIGHT / 2, r);
+        });
+    }
+}
+
+static void bench_rainbow_draw_line(Bench& bench) {
+    Knife knife;
+    for (int length : {10, 100, 300}) {
+        Knife::Point a = {10, 10};
+        Knife::Point b = {10 + length,
+                          10 + length * ((int)LCD_HEIGHT - 20) / 300};
+        bench.run("rainbow_draw_line", {{"length", std::to_string(length)}},
+                  [&] { knife.rainbow_draw_line(a, b); });
+    }
+}
+
+static void bench_entities_physics(Bench& bench) {
+    for (size_t n : {16, 256, 4096}) {
+        Entities entities;
+        for (size_t i = 0; i < n; i++) {
+            entities.add(
+                EntityType::Apple, SpriteId::Apple, 13, 8,
+                Vector2(rand_range(0, LCD_WIDTH), rand_range(0, LCD_HEIGHT)));
+        }
+
+        for (uint32_t steps : {1, 4}) {
+            Bench::Options options;
+            options.items = n * steps;
+            bench.run("entities_physics_update",
+                      {{"objects", std::to_string(n)},
+                       {"steps", std::to_string(steps)}},
+                      [&] { entities.physics_update(0.01, steps); }, options);
+        }
+    }
+}
+
+static void bench_entities_frame(Bench& bench) {
+    // everything entities cost in a frame: two physics steps (a 60 Hz frame
+    // at 100 Hz physics) and working out where to draw them
+    for (bool ballistic : {false, true}) {
+        for (size_t n : {256, 4096}) {
+            Entities entities;
+            entities.ballistic = ballistic;
+            for (size_t i = 0; i < n; i++) {
+                entities.launch(EntityType::Apple, SpriteId::Apple, 13, 8,
+                                Vector2(rand_range(0, LCD_WIDTH),
+                                        rand_range(0, LCD_HEIGHT)),
+                                Vector2(rand_range(-80000, 80000),
+                                        rand_range(-360000, -260000)),
+                                0, 0.01);
+            }
+
+            const char* mode = ballistic ? "ballistic" : "integrated";
+            double t = 0;
+            Bench::Options options;
+            options.items = n;
+            bench.run(
+                "entities_frame",
+                {{"mode", Bench::string(mode)},
+                 {"objects", std::to_string(n)}},
+                [&] {
+                    entities.physics_update(0.01, 2);
+                    t += 0.02;
+                    entities.interpolate(0.5, t - 0.005);
+                },
+                options);
+        }
+    }
+}
+
+static void bench_knife_broadphase(Bench& bench) {
+    // a frame's worth of knife: the grid is built once, then a trail of short
+    // segments across the middle of the screen is tested against it
+    const int SEGMENTS = 8;
+    for (size_t n : {16, 256, 4096}) {
+        Entities entities;
+        for (size_t i = 0; i < n; i++) {
+            entities.add(
+                EntityType::Apple, SpriteId::Apple, 13, 8,
+                Vector2(rand_range(0, LCD_WIDTH), rand_range(0, LCD_HEIGHT)));
+        }
+
+        auto segment = [](int s, Vector2& p1, Vector2& p2) {
+            p1 = Vector2(100 + s * 15, 100 + s * 5);
+            p2 = Vector2(115 + s * 15, 105 + s * 5);
+        };
+
+        Bench::Options options;
+        options.items = n;
+        size_t hits = 0;
+        bench.run("knife_broadphase",
+                  {{"objects", std::to_string(n)},
+                   {"method", Bench::string("all")}},
+                  [&] {
+                      Vector2 p1, p2;
+                      for (int s = 0; s < SEGMENTS; s++) {
+                          segment(s, p1, p2);
+                          for (size_t i = 0; i < n; i++) {
+                              hits += collide_line_circle(
+                                  p1, p2, entities.position(i),
+                                  entities.radius[i]);
+                          }
+                      }
+                  },
+                  options);
+
+        SpatialGrid grid;
+        std::vector<uint32_t> found;
+        bench.run("knife_broadphase",
+                  {{"objects", std::to_string(n)},
+                   {"method", Bench::string("grid")}},
+                  [&] {
+                      Vector2 p1, p2;
+                      grid.build(entities.draw_x.data(),
+                                 entities.draw_y.data(),
+                                 entities.draw_x.data(),
+                                 entities.draw_y.data(),
+                                 entities.radius.data(), n,
+                                 config.knife_grid_cell_size);
+                      for (int s = 0; s < SEGMENTS; s++) {
+                          segment(s, p1, p2);
+                          grid.query(p1, p2, found);
+                          for (uint32_t i : found) {
+                              hits += collide_line_circle(
+                                  p1, p2, entities.position(i),
+                                  entities.radius[i]);
+                          }
+                      }
+                  },
+                  options);
+        do_not_optimize(hits);
+    }
+}
+
+static void bench_object_broadphase(Bench& bench) {
+    // fruits spread over the screen drifting a little every step, as in a
+    // physics step of a busy game
+    for (size_t n : {256, 1024, 4096}) {
+        Entities entities;
+        std::vector<float> xs, ys, drift;
+        for (size_t i = 0; i < n; i++) {
+            entities.add(EntityType::Apple, SpriteId::Apple, 13, 8, {});
+            xs.push_back(rand_range(0, LCD_WIDTH));
+            ys.push_back(rand_range(0, LCD_HEIGHT));
+            drift.push_back(rand_range(-2, 2));
+        }
+
+        Bench::Options options;
+        options.items = n;
+        size_t pairs = 0;
+        bench.run("object_broadphase",
+                  {{"objects", std::to_string(n)},
+                   {"method", Bench::string("all")}},
+                  [&] {
+                      for (size_t i = 0; i < n; i++) {
+                          for (size_t j = i + 1; j < n; j++) {
+                              float reach = entities.radius[i] +
+                                            entities.radius[j];
+                              pairs += std::abs(xs[i] - xs[j]) <= reach &&
+                                       std::abs(ys[i] - ys[j]) <= reach;
+                          }
+                      }
+                  },
+                  options);
+
+        SweepAndPrune sweep;
+        std::vector<EntityPair> found;
+        bench.run("object_broadphase",
+                  {{"objects", std::to_string(n)},
+                   {"method", Bench::string("sweep")}},
+                  [&] {
+                      for (size_t i = 0; i < n; i++) {
+                          xs[i] += drift[i];
+                          if (xs[i] < 0 || xs[i] > LCD_WIDTH)
+                              drift[i] = -drift[i];
+                      }
+                      sweep.update(entities, xs.data(), ys.data(), found);
+                      pairs += found.size();
+                  },
+                  options);
+        do_not_optimize(pairs);
+    }
+}
+
+static void bench_particles(Bench& bench) {
+    // an explosion's worth and a full pool, which live long enough that
+    // none of them die while being timed
+    for (size_t n : {192, 2000}) {
+        Particles particles;
+        particles.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            float angle = rand_range(0, 6.28f);
+            particles.emit(Vector2(LCD_WIDTH / 2, LCD_HEIGHT / 2),
+                           Vector2(std::cos(angle), std::sin(angle)) * 0.01f,
+                           0, rand_range(2, 12), RED, 1e9);
+        }
+
+        Bench::Params params = {{"particles", std::to_string(n)}};
+        bench.run("particles_physics_update", params,
+                  [&] { particles.physics_update(0.01); });
+        bench.run("particles_render", params, [&] { particles.render(); });
+
+        // what render used to do, as a baseline for the disc spans: a
+        // fill_circle per particle, whose lines overlap and are each clipped
+        // and marked dirty on their own
+        bench.run("particles_render_fill_circle", params, [&] {
+            for (size_t i = 0; i < particles.size(); i++) {
+                float r = particles.radius[i] * particles.life[i] /
+                          particles.lifetime[i];
+                framebuffer->set_color(particles.color[i]);
+                fill_circle(particles.x[i], particles.y[i], (int)(r + 0.5f));
+            }
+        });
+    }
+}
+
+static void bench_game_physics(Bench& bench) {
+    // the same scene every sample: a fixed seed, then enough simulated time
+    // for a handful of objects to be in the air
+    const int WARMUP_STEPS = 1000;
+    double t = 0;
+    Bench::Options options;
+    options.max_iterations = 200;
+    options.setup = [&] {
+        srand(1);
+        game->start(0.12, 1);
+        for (t = 0; t < WARMUP_STEPS * 0.01; t += 0.01)
+            game->physics_update(t, 0.01);
+    };
+
+    bench.run(
+        "game_physics_update", {{"warmup_steps", std::to_string(WARMUP_STEPS)}},
+        [&] {
+            game->physics_update(t, 0.01);
+            t += 0.01;
+        },
+        options);
+}
+
+static void bench_leaderboard(Bench& bench) {
+    for (size_t n : {10, 1000, 100000}) {
+        std::unique_ptr<Leaderboard> leaderboard;
+        Bench::Options options;
+        options.setup = [&] {
+            std::ofstream csv("leaderboard.csv");
+            for (size_t i = 0; i < n; i++)
+                csv << "player" << i << "," << rand() % 1000 << "\n";
+            csv.close();
+            leaderboard = std::make_unique<Leaderboard>();
+        };
+
+        bench.run(
+            "leaderboard_add_entry", {{"entries", std::to_string(n)}},
+            [&] {
+                leaderboard->add_entry({"bench", (uint64_t)(rand() % 1000)});
+            },
+            options);
+    }
+}
+
+/// Entrypoint of the benchmarks
+/// @param argc number of command line arguments
+/// @param argv substrings of the names of benchmarks to run
+/// Random float which is a whole number a quarter of the time, so that
+/// comparisons which land exactly on the boundary come up
+/// @param lower lower bound
+/// @param upper upper bound
+static float rand_input(float lower, float upper) {
+    float value = rand_range(lower, upper);
+    return rand() % 4 == 0 ? std::floor(value) : value;
+}
+
+/// Random pixel, with alphas around OPAQUE_ALPHA and the ends of the range
+/// more likely than the rest
+static uint32_t rand_pixel() {
+    static const uint32_t ALPHAS[] = {0x00, 0x01, OPAQUE_ALPHA - 1,
+                                      OPAQUE_ALPHA, OPAQUE_ALPHA + 1, 0xFF};
+    uint32_t rgb = ((uint32_t)rand() << 8 ^ (uint32_t)rand()) & 0xFFFFFF;
+    uint32_t alpha = rand() % 2 ? ALPHAS[rand() % 6] : rand() & 0xFF;
+    return alpha << 24 | rgb;
+}
+
+/// Random number of items, to cover the vector loops along with every length
+/// of scalar tail after them
+static size_t rand_count() {
+    return rand() % 8 == 0 ? rand() % 8 : rand() % 200;
+}
+
+/// Number of random inputs each kernel is checked against
+static const int CHECK_RUNS = 2000;
+
+/// Report the result of checking one kernel
+/// @param name name of the kernel
+/// @param failures number of runs where the versions differed
+/// @return whether the versions always matched
+static bool check_report(const char* name, int failures) {
+    std::cerr << "check " << name << ": " << CHECK_RUNS - failures << "/"
+              << CHECK_RUNS << " runs match" << std::endl;
+    return failures == 0;
+}
+
+static bool check_blit_span() {
+    int failures = 0;
+    for (int run = 0; run < CHECK_RUNS; run++) {
+        // start part way into the buffers so loads are unaligned too
+        size_t offset = rand() % 8;
+        size_t n = rand_count();
+        std::vector<uint32_t> src(offset + n), dst(offset + n);
+        for (size_t i = 0; i < offset + n; i++) {
+            src[i] = rand_pixel();
+            dst[i] = rand_pixel();
+        }
+
+        std::vector<uint32_t> expected = dst;
+        blit_span(dst.data() + offset, src.data() + offset, n);
+        blit_span_scalar(expected.data() + offset, src.data() + offset, n);
+        failures += dst != expected;
+    }
+    return check_report("blit_span", failures);
+}
+
+static bool check_integrate() {
+    int failures = 0;
+    for (int run = 0; run < CHECK_RUNS; run++) {
+        size_t n = rand_count();
+        float gravity = rand_input(0, 500);
+        float dt = rand() % 2 ? 0.01f : rand_range(0.001f, 0.05f);
+        uint32_t steps = 1 + rand() % 5;
+
+        // columns x, y, vx, vy, prev_x, prev_y, prev_vx, prev_vy, ax, ay
+        std::vector<float> columns[2][10];
+        for (auto& column : columns[0]) {
+            column.resize(n);
+            for (float& value : column)
+                value = rand_input(-500, 500);
+        }
+        std::copy(std::begin(columns[0]), std::end(columns[0]),
+                  std::begin(columns[1]));
+
+        BodyColumns bodies[2];
+        for (int k = 0; k < 2; k++) {
+            std::vector<float>* c = columns[k];
+            bodies[k] = {c[0].data(), c[1].data(), c[2].data(), c[3].data(),
+                         c[4].data(), c[5].data(), c[6].data(), c[7].data(),
+                         c[8].data(), c[9].data()};
+        }
+
+        integrate(bodies[0], n, gravity, dt, steps);
+        integrate_scalar(bodies[1], n, gravity, dt, steps);
+
+        // compared bit for bit, since the versions do the same operations
+        bool match = true;
+        for (int c = 0; c < 10; c++)
+            match &= std::memcmp(columns[0][c].data(), columns[1][c].data(),
+                                 n * sizeof(float)) == 0;
+        failures += !match;
+    }
+    return check_report("integrate", failures);
+}
+
+static bool check_collide_line_circles() {
+    int failures = 0;
+    for (int run = 0; run < CHECK_RUNS; run++) {
+        size_t n = rand_count();
+        Vector2 l1(rand_input(-50, 370), rand_input(-50, 290));
+        // a segment with no length now and then
+        Vector2 l2 = rand() % 8 ? Vector2(rand_input(-50, 370),
+                                          rand_input(-50, 290))
+                                : l1;
+
+        std::vector<float> x(n), y(n), r(n);
+        for (size_t i = 0; i < n; i++) {
+            x[i] = rand_input(-50, 370);
+            y[i] = rand_input(-50, 290);
+            r[i] = rand() % 16 ? rand_input(0, 40) : 0;
+        }
+
+        std::vector<uint64_t> hits((n + 63) / 64), expected(hits.size());
+        collide_line_circles(l1, l2, x.data(), y.data(), r.data(), n,
+                             hits.data());
+        collide_line_circles_scalar(l1, l2, x.data(), y.data(), r.data(), n,
+                                    expected.data());
+        failures += hits != expected;
+    }
+    return check_report("collide_line_circles", failures);
+}
+
+static bool check_collide_swept_circles() {
+    int failures = 0;
+    for (int run = 0; run < CHECK_RUNS; run++) {
+        size_t n = rand_count();
+        Vector2 k1(rand_input(-50, 370), rand_input(-50, 290));
+        Vector2 k2 = rand() % 8 ? Vector2(rand_input(-50, 370),
+                                          rand_input(-50, 290))
+                                : k1;
+
+        std::vector<float> x1(n), y1(n), x2(n), y2(n), r(n);
+        for (size_t i = 0; i < n; i++) {
+            x1[i] = rand_input(-50, 370);
+            y1[i] = rand_input(-50, 290);
+            // circles which move the same as the point, so that neither moves
+            // relative to the other, now and then
+            bool still = rand() % 8 == 0;
+            x2[i] = still ? x1[i] + k2.x - k1.x : rand_input(-50, 370);
+            y2[i] = still ? y1[i] + k2.y - k1.y : rand_input(-50, 290);
+            r[i] = rand() % 16 ? rand_input(0, 40) : 0;
+        }
+
+        std::vector<uint64_t> hits((n + 63) / 64), expected(hits.size());
+        collide_swept_circles(k1, k2, x1.data(), y1.data(), x2.data(),
+                              y2.data(), r.data(), n, hits.data());
+        collide_swept_circles_scalar(k1, k2, x1.data(), y1.data(), x2.data(),
+                                     y2.data(), r.data(), n, expected.data());
+        failures += hits != expected;
+    }
+    return check_report("collide_swept_circles", failures);
+}
+
+/// Check every SIMD kernel against its scalar version
+/// @return whether they all matched
+static bool check_kernels() {
+#if defined(__AVX2__)
+    std::cerr << "checking the AVX2 and SSE2 kernels" << std::endl;
+#elif defined(__SSE2__)
+    std::cerr << "checking the SSE2 kernels" << std::endl;
+#else
+    std::cerr << "no vector kernels are built, checking the scalar ones "
+                 "against themselves"
+              << std::endl;
+#endif
+
+    bool ok = true;
+    ok &= check_blit_span();
+    ok &= check_integrate();
+    ok &= check_collide_line_circles();
+    ok &= check_collide_swept_circles();
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    srand(1);
+    if (argc == 2 && std::string(argv[1]) == "--check")
+        return check_kernels() ? 0 : 1;
+
+    // the leaderboard is saved in the working directory, so work somewhere
+    // that will not clobber the real one
+    namespace fs = std::filesystem;
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    fs::path dir =
+        fs::temp_directory_path() / ("fruity-bench-" + std::to_string(now));
+    fs::create_directories(dir);
+    fs::current_path(dir);
+
+    Bench bench(std::vector<std::string>(argv + 1, argv + argc));
+    bench_image_render(bench);
+    bench_collide_line_circle(bench);
+    bench_sprite_segment_hits(bench);
+    bench_circles(bench);
+    bench_rainbow_draw_line(bench);
+    bench_entities_physics(bench);
+    bench_entities_frame(bench);
+    bench_knife_broadphase(bench);
+    bench_object_broadphase(bench);
+    bench_particles(bench);
+    bench_game_physics(bench);
+    bench_leaderboard(bench);
+    bench.report(std::cout);
+
+    fs::current_path(fs::temp_directory_path());
+    fs::remove_all(dir);
+    return 0;
+}
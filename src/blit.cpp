@@ -0,0 +1,53 @@
+/// @file blit.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of the span copying kernels, with AVX2 and SSE2
+/// versions picked at compile time and a scalar fallback for everything else
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "blit.h"
+
+// an alpha of at least 0x80 is exactly the top bit of the pixel, which is
+// the sign bit the vector kernels pick lanes by
+static_assert(OPAQUE_ALPHA == 0x80, "blit_span tests the top bit of alpha");
+
+void blit_span(uint32_t* dst, const uint32_t* src, size_t n) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        __m256 s = _mm256_castsi256_ps(
+            _mm256_loadu_si256((const __m256i*)(src + i)));
+        __m256 d = _mm256_castsi256_ps(
+            _mm256_loadu_si256((const __m256i*)(dst + i)));
+        // lanes which are transparent keep the destination pixel
+        _mm256_storeu_si256((__m256i*)(dst + i),
+                            _mm256_castps_si256(_mm256_blendv_ps(d, s, s)));
+    }
+#endif
+
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i opaque = _mm_srai_epi32(s, 31);
+        _mm_storeu_si128((__m128i*)(dst + i),
+                         _mm_or_si128(_mm_and_si128(opaque, s),
+                                      _mm_andnot_si128(opaque, d)));
+    }
+#endif
+
+    blit_span_scalar(dst + i, src + i, n - i);
+}
+
+void blit_span_scalar(uint32_t* dst, const uint32_t* src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if ((src[i] >> 24) >= OPAQUE_ALPHA)
+            dst[i] = src[i];
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+/// @file blit.h
+/// @author Mark Bundschuh
+/// @brief Pixel storage and low level span copying kernels
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/// Alignment in bytes of pixel buffers, wide enough for a 256 bit AVX2 load
+constexpr size_t PIXEL_ALIGNMENT = 32;
+
+/// Lowest alpha of a pixel which is drawn, whether or not the image is
+/// rotated, and which counts as opaque for collisions. Anything more
+/// transparent is skipped.
+constexpr uint32_t OPAQUE_ALPHA = 0x80;
+
+/// Allocator which aligns its storage to a given boundary
+/// @tparam T type being allocated
+/// @tparam Alignment alignment in bytes of every allocation
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(
+            ::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const {
+        return false;
+    }
+};
+
+/// Contiguous, aligned, row-major storage of 0xAARRGGBB pixels
+using PixelBuffer =
+    std::vector<uint32_t, AlignedAllocator<uint32_t, PIXEL_ALIGNMENT>>;
+
+/// Copy a span of pixels, skipping every pixel whose alpha is below
+/// OPAQUE_ALPHA
+/// @param dst destination pixels
+/// @param src source pixels
+/// @param n number of pixels in the span
+void blit_span(uint32_t* dst, const uint32_t* src, size_t n);
+
+/// One pixel at a time version of blit_span, which the vector versions have to
+/// match exactly (checked by `bench.out --check`)
+/// @param dst destination pixels
+/// @param src source pixels
+/// @param n number of pixels in the span
+void blit_span_scalar(uint32_t* dst, const uint32_t* src, size_t n);
@@ -0,0 +1,80 @@
+#pragma once
+
+/// @file config.h
+/// @author Mark Bundschuh
+/// @brief Tunable engine settings
+
+#include <cstddef>
+
+/// Settings which trade memory or quality for speed, and the limits of the
+/// stress test
+struct Config {
+    /// Number of quantized angles in a full turn that rotated sprites are
+    /// pre-rendered at
+    size_t rotation_steps = 64;
+
+    /// Maximum number of bytes of pre-rotated sprites to keep cached before
+    /// evicting the least recently used ones
+    size_t rotation_cache_budget = 8 * 1024 * 1024;
+
+    /// Whether thrown objects follow their closed-form trajectories instead of
+    /// being integrated every physics step. Takes effect on the next game.
+    bool ballistic_physics = false;
+
+    /// Most fruits and bombs that can be in the air at once. Storage for them
+    /// is allocated when a game starts, and nothing more is thrown while it is
+    /// full.
+    size_t throwable_pool_size = 5000;
+
+    /// Most fruit shards that can be in the air at once. Fruits cut while it
+    /// is full vanish without leaving shards.
+    size_t shard_pool_size = 1000;
+
+    /// Width and height in pixels of the cells of the grid which finds the
+    /// objects near the knife
+    int knife_grid_cell_size = 32;
+
+    /// Whether fruits and bombs bounce off each other
+    bool object_collisions = true;
+
+    /// Fraction of the speed at which two objects hit each other that they
+    /// bounce apart with
+    float object_restitution = 0.5;
+
+    /// Most particles alive at once. Effects are missing whatever particles
+    /// do not fit while it is full.
+    size_t particle_pool_size = 2000;
+
+    /// Particles in the explosion of a bomb
+    size_t explosion_particles = 192;
+
+    /// Drops of juice splashed by a fruit when it is cut
+    size_t juice_particles = 12;
+
+    /// Sparks thrown off by a fruit when it is cut
+    size_t spark_particles = 6;
+
+    /// Objects per second the stress test starts out throwing
+    float stress_start_rate = 10;
+
+    /// Objects per second the stress test's spawn rate grows by every second
+    float stress_spawn_ramp = 20;
+
+    /// Highest number of objects per second the stress test throws
+    float stress_max_rate = 2000;
+
+    /// Most objects the stress test keeps alive at once. Spawning pauses while
+    /// there are this many.
+    size_t stress_max_objects = 5000;
+
+    /// Seconds a frame may take before the stress test considers itself over
+    /// budget and stops
+    double stress_frame_budget = 1.0 / 30;
+
+    /// Seconds of game time the stress test runs for before stopping on its
+    /// own
+    double stress_duration = 120;
+};
+
+/// Global variable to hold the engine settings
+inline Config config;
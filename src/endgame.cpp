@@ -10,7 +10,9 @@
 #include "FEHLCD.h"
 
 #include "endgame.h"
+#include "framebuffer.h"
 #include "menu.h"
+#include "tasks.h"
 #include "ui.h"
 #include "util.h"
 
@@ -69,25 +71,26 @@ EndGame::EndGame() {
     confirm_button->bind_on_button_up([this]() {
         std::replace(name.begin(), name.end(), '_', ' ');
         menu->leaderboard.add_entry({.name = name, .points = points});
-        current_scene = menu;
+        scheduler->change_scene(menu);
     });
 
     background = image_repository->load_image("assets/background-menu.png");
 }
 
 void EndGame::update(double alpha) {
-    background->render(LCD_WIDTH / 2, LCD_HEIGHT / 2, 0);
+    framebuffer->draw_background(*background);
 
-    LCD.SetFontColor(WHITE);
+    framebuffer->set_color(WHITE);
     const auto points_str = std::to_string(points);
-    LCD.WriteAt(
-        points_str.c_str(),
+    framebuffer->write_at(
+        points_str,
         (LCD_WIDTH / 2.0) - (points_str.size() * FONT_GLYPH_WIDTH / 2.0),
         FONT_GLYPH_HEIGHT);
-    LCD.WriteAt("Enter Name", (LCD_WIDTH / 2.0) - (5 * FONT_GLYPH_WIDTH),
-                FONT_GLYPH_HEIGHT * 2 + 4 * 1);
-    LCD.WriteAt(name.c_str(), (LCD_WIDTH / 2.0) - (1.5 * FONT_GLYPH_WIDTH),
-                FONT_GLYPH_HEIGHT * 3 + 4 * 2);
+    framebuffer->write_at("Enter Name",
+                          (LCD_WIDTH / 2.0) - (5 * FONT_GLYPH_WIDTH),
+                          FONT_GLYPH_HEIGHT * 2 + 4 * 1);
+    framebuffer->write_at(name, (LCD_WIDTH / 2.0) - (1.5 * FONT_GLYPH_WIDTH),
+                          FONT_GLYPH_HEIGHT * 3 + 4 * 2);
 
     std::for_each(row1.begin(), row1.end(), [](auto& a) { a->update(); });
     std::for_each(row2.begin(), row2.end(), [](auto& a) { a->update(); });
@@ -0,0 +1,234 @@
+/// @file entities.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of the entity storage
+
+#include <algorithm>
+#include <cstdio>
+
+#include "entities.h"
+#include "integrate.h"
+
+/// Downward acceleration of gravity on every entity, in pixels per second
+/// squared
+static const float GRAVITY = 437.5f;
+
+/// Name of each entity pool, indexed by EntityPool
+static const char* const POOL_NAMES[ENTITY_POOLS] = {"throwable", "shard"};
+
+void Entities::reserve(size_t throwables, size_t shards) {
+    pool_stats[(size_t)EntityPool::Throwable].capacity = throwables;
+    pool_stats[(size_t)EntityPool::Shard].capacity = shards;
+
+    size_t total = throwables + shards;
+    for_each_column([=](auto& column) { column.reserve(total); });
+    slot_index.reserve(total);
+    generations.reserve(total);
+    free_slots.reserve(total);
+}
+
+bool Entities::add(EntityType type,
+                   SpriteId sprite,
+                   float radius,
+                   float mass,
+                   Vector2 pos) {
+    PoolStats& stats = pool_stats[(size_t)pool(type)];
+    if (stats.live >= stats.capacity) {
+        stats.exhausted++;
+        return false;
+    }
+    stats.live++;
+    stats.high_water = std::max(stats.high_water, stats.live);
+
+    size_t i = size();
+    for_each_column([](auto& column) { column.emplace_back(); });
+
+    x[i] = prev_x[i] = draw_x[i] = pos.x;
+    y[i] = prev_y[i] = draw_y[i] = pos.y;
+    this->radius[i] = radius;
+    this->mass[i] = mass;
+    this->sprite[i] = sprite;
+    this->type[i] = type;
+
+    if (free_slots.empty()) {
+        slot_index.push_back(i);
+        generations.push_back(0);
+        slot[i] = slot_index.size() - 1;
+    } else {
+        slot[i] = free_slots.back();
+        free_slots.pop_back();
+        slot_index[slot[i]] = i;
+    }
+    return true;
+}
+
+bool Entities::launch(EntityType type,
+                      SpriteId sprite,
+                      float radius,
+                      float mass,
+                      Vector2 pos,
+                      Vector2 force,
+                      double t,
+                      double dt) {
+    if (!add(type, sprite, radius, mass, pos))
+        return false;
+
+    // Integrating would leave the entity moving at (force / mass + gravity) *
+    // dt after the first step, and gravity only adds to that afterwards. The
+    // parabola through every one of those steps starts half a step of gravity
+    // slower, so both modes agree wherever they are both sampled.
+    size_t i = size() - 1;
+    float step = dt;
+    launch_t[i] = t;
+    launch_x[i] = pos.x;
+    launch_y[i] = pos.y;
+    launch_vx[i] = force.x / mass * step;
+    launch_vy[i] = force.y / mass * step + GRAVITY * step / 2;
+
+    if (!ballistic)
+        add_force(i, force);
+    return true;
+}
+
+Vector2 Entities::position_at(size_t i, double t) const {
+    float dt = std::max(t - launch_t[i], 0.0);
+    return {launch_x[i] + launch_vx[i] * dt,
+            launch_y[i] + (launch_vy[i] + GRAVITY / 2 * dt) * dt};
+}
+
+Vector2 Entities::velocity_at(size_t i, double t, double dt) const {
+    // the parabola's own velocity runs half a step of gravity ahead of the
+    // one integration keeps, as in launch
+    float step = dt;
+    float since = std::max(t - launch_t[i], 0.0);
+    return {launch_vx[i], launch_vy[i] + GRAVITY * (since - step / 2)};
+}
+
+void Entities::redirect(size_t i,
+                        double t,
+                        double dt,
+                        Vector2 pos,
+                        Vector2 velocity) {
+    float step = dt;
+    launch_t[i] = t;
+    launch_x[i] = pos.x;
+    launch_y[i] = pos.y;
+    launch_vx[i] = velocity.x;
+    launch_vy[i] = velocity.y + GRAVITY * step / 2;
+
+    if (!ballistic) {
+        x[i] = pos.x;
+        y[i] = pos.y;
+        vx[i] = velocity.x;
+        vy[i] = velocity.y;
+    }
+}
+
+void Entities::add_force(size_t i, Vector2 force) {
+    // Newton's 2nd law: f = m * a or a = f / m
+    ax[i] += force.x / mass[i];
+    ay[i] += force.y / mass[i];
+}
+
+void Entities::clear() {
+    for_each_column([](auto& column) { column.clear(); });
+    for (PoolStats& stats : pool_stats)
+        stats.live = 0;
+
+    // every slot is free again, but keeps counting generations so that old
+    // handles to it never find anything
+    free_slots.clear();
+    for (size_t s = slot_index.size(); s-- > 0;)
+        free_slots.push_back(s);
+    for (uint32_t& generation : generations)
+        generation++;
+}
+
+void Entities::remove_flagged() {
+    size_t i = 0;
+    while (i < size()) {
+        if (!(flags[i] & ENTITY_REMOVED)) {
+            i++;
+            continue;
+        }
+
+        generations[slot[i]]++;
+        free_slots.push_back(slot[i]);
+        pool_stats[(size_t)pool(type[i])].live--;
+
+        // the last entity takes its place, and is checked next
+        size_t last = size() - 1;
+        if (i != last) {
+            for_each_column([=](auto& column) { column[i] = column[last]; });
+            slot_index[slot[i]] = i;
+        }
+        for_each_column([](auto& column) { column.pop_back(); });
+    }
+}
+
+bool Entities::find(EntityHandle handle, size_t& i) const {
+    if (handle.slot >= generations.size() ||
+        generations[handle.slot] != handle.generation)
+        return false;
+
+    i = slot_index[handle.slot];
+    return true;
+}
+
+void Entities::physics_update(double dt, uint32_t steps) {
+    physics_update(dt, steps, 0, size());
+}
+
+void Entities::physics_update(double dt,
+                              uint32_t steps,
+                              size_t begin,
+                              size_t end) {
+    if (ballistic || begin >= end || steps == 0)
+        return;
+
+    BodyColumns bodies = {
+        x.data() + begin,       y.data() + begin,       vx.data() + begin,
+        vy.data() + begin,      prev_x.data() + begin,  prev_y.data() + begin,
+        prev_vx.data() + begin, prev_vy.data() + begin, ax.data() + begin,
+        ay.data() + begin,
+    };
+    integrate(bodies, end - begin, GRAVITY, dt, steps);
+}
+
+void Entities::interpolate(double alpha, double t) {
+    if (ballistic) {
+        for (size_t i = 0; i < size(); i++) {
+            // entities thrown this frame have not left yet
+            float dt = std::max(t - launch_t[i], 0.0);
+            draw_x[i] = launch_x[i] + launch_vx[i] * dt;
+            draw_y[i] =
+                launch_y[i] + (launch_vy[i] + GRAVITY / 2 * dt) * dt;
+            draw_vx[i] = launch_vx[i];
+        }
+        return;
+    }
+
+    float a = alpha;
+    float b = 1.0 - alpha;
+    for (size_t i = 0; i < size(); i++) {
+        draw_x[i] = x[i] * a + prev_x[i] * b;
+        draw_y[i] = y[i] * a + prev_y[i] * b;
+        draw_vx[i] = vx[i] * a + prev_vx[i] * b;
+    }
+}
+
+void report_pool(std::ostream& out, const char* name, const PoolStats& stats) {
+    char capacity[32] = "unreserved";
+    if (stats.capacity != SIZE_MAX)
+        std::snprintf(capacity, sizeof(capacity), "%zu", stats.capacity);
+
+    char line[128];
+    std::snprintf(line, sizeof(line),
+                  "pool %s: capacity %s, high water %zu, exhausted %zu\n", name,
+                  capacity, stats.high_water, stats.exhausted);
+    out << line;
+}
+
+void Entities::report(std::ostream& out) const {
+    for (size_t p = 0; p < ENTITY_POOLS; p++)
+        report_pool(out, POOL_NAMES[p], pool_stats[p]);
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+/// @file entities.h
+/// @author Mark Bundschuh
+/// @brief Structure of arrays storage for every thrown object in the game
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "sprites.h"
+#include "util.h"
+
+/// What an entity is
+enum class EntityType : uint8_t {
+    Apple,
+    Bananas,
+    Orange,
+    Cherries,
+    Strawberry,
+    Pineapple,
+    Bomb,
+    /// Half of a fruit after it is cut
+    Shard,
+};
+
+/// Number of types of thrown objects (everything but shards)
+const size_t THROWABLE_TYPES = (size_t)EntityType::Shard;
+
+/// Groups of entities which each get their own share of the storage, so that
+/// running out of room for one does not take it from the others
+enum class EntityPool : uint8_t {
+    /// Fruits and bombs
+    Throwable,
+    Shard,
+};
+
+/// Number of entity pools
+const size_t ENTITY_POOLS = 2;
+
+/// How full an entity pool is and has been
+struct PoolStats {
+    /// Most entities the pool holds at once, which is unlimited until the pool
+    /// is reserved
+    size_t capacity = SIZE_MAX;
+    /// Number of entities in the pool now
+    size_t live = 0;
+    /// Most entities the pool has held at once
+    size_t high_water = 0;
+    /// Number of entities turned away because the pool was full
+    size_t exhausted = 0;
+};
+
+/// Write how full a pool has been as one line
+/// @param out stream to write to
+/// @param name name of the pool
+/// @param stats usage of the pool
+void report_pool(std::ostream& out, const char* name, const PoolStats& stats);
+
+/// Bits of Entities::flags
+enum EntityFlags : uint8_t {
+    /// Entity is gone and will be dropped by the next remove_flagged
+    ENTITY_REMOVED = 1 << 0,
+};
+
+/// Stable reference to an entity which stays valid while the entity moves
+/// around the columns, and stops finding anything once it is removed
+struct EntityHandle {
+    uint32_t slot;
+    /// Number of times the slot had been reused when the handle was made
+    uint32_t generation;
+};
+
+/// Every fruit, bomb, and fruit shard, stored as a structure of arrays so
+/// each pass over them streams through only the columns it needs. An entity
+/// is an index into every column; indices are only stable until the next
+/// remove_flagged, which moves the last entity into each removed one's place.
+/// Anything that needs to refer to an entity for longer keeps an EntityHandle.
+class Entities {
+   public:
+    /// Number of entities
+    size_t size() const { return type.size(); }
+
+    /// Set how many entities of each pool there is room for and allocate all
+    /// of it up front, so that adding entities never allocates. Until this is
+    /// called there is no limit.
+    /// @param throwables room for fruits and bombs
+    /// @param shards room for fruit shards
+    void reserve(size_t throwables, size_t shards);
+
+    /// Add an entity at rest, at the end of the columns
+    /// @param type what the entity is
+    /// @param sprite what the entity looks like
+    /// @param radius collision radius in pixels
+    /// @param mass mass of the entity
+    /// @param pos screenspace position to place the entity
+    /// @return whether there was room for it
+    bool add(EntityType type,
+             SpriteId sprite,
+             float radius,
+             float mass,
+             Vector2 pos);
+
+    /// Add an entity and throw it with an impulse force, applied over the next
+    /// physics step
+    /// @param type what the entity is
+    /// @param sprite what the entity looks like
+    /// @param radius collision radius in pixels
+    /// @param mass mass of the entity
+    /// @param pos screenspace position to throw the entity from
+    /// @param force 2D force vector to apply as an impulse force
+    /// @param t physics time at the start of the next physics step
+    /// @param dt physics timestep
+    /// @return whether there was room for it
+    bool launch(EntityType type,
+                SpriteId sprite,
+                float radius,
+                float mass,
+                Vector2 pos,
+                Vector2 force,
+                double t,
+                double dt);
+
+    /// Add an impulse force to an entity, applied over the next physics step.
+    /// Ballistic entities ignore it.
+    /// @param i index of the entity
+    /// @param force 2D force vector to apply as an impulse force
+    void add_force(size_t i, Vector2 force);
+
+    /// Remove every entity, invalidating every handle
+    void clear();
+
+    /// Drop every entity flagged ENTITY_REMOVED by moving the last entity into
+    /// its place. Entities are only ever destroyed here, so indices stay valid
+    /// from one call to the next.
+    void remove_flagged();
+
+    /// Handle to an entity
+    /// @param i index of the entity
+    EntityHandle handle(size_t i) const {
+        return {slot[i], generations[slot[i]]};
+    }
+
+    /// Look up where an entity is now
+    /// @param handle handle to the entity
+    /// @param i set to the index of the entity if it still exists
+    /// @return whether the entity still exists
+    bool find(EntityHandle handle, size_t& i) const;
+
+    /// How full an entity pool is and has been
+    /// @param pool which pool
+    const PoolStats& stats(EntityPool pool) const {
+        return pool_stats[(size_t)pool];
+    }
+
+    /// Write how full every pool has been, one line each
+    /// @param out stream to write to
+    void report(std::ostream& out) const;
+
+    /// Apply gravity and advance every entity by semi-implicit Euler steps.
+    /// Does nothing when ballistic.
+    /// @param dt physics timestep
+    /// @param steps number of timesteps to advance by
+    void physics_update(double dt, uint32_t steps = 1);
+
+    /// Apply gravity and advance a range of entities by semi-implicit Euler
+    /// steps
+    /// @param dt physics timestep
+    /// @param steps number of timesteps to advance by
+    /// @param begin index of the first entity to advance
+    /// @param end index past the last entity to advance
+    void physics_update(double dt, uint32_t steps, size_t begin, size_t end);
+
+    /// Interpolate every entity's draw position between its previous and
+    /// current physics state, or evaluate its trajectory when ballistic
+    /// @param alpha physics alpha, for interpolation between previous state and
+    /// next state
+    /// @param t physics time that alpha corresponds to
+    void interpolate(double alpha, double t);
+
+    /// Interpolated position of an entity, where it is drawn
+    /// @param i index of the entity
+    Vector2 position(size_t i) const { return {draw_x[i], draw_y[i]}; }
+
+    /// Position of a launched entity at any physics time, on the parabola it
+    /// was launched along. This matches where integration puts it after every
+    /// step.
+    /// @param i index of the entity
+    /// @param t physics time
+    Vector2 position_at(size_t i, double t) const;
+
+    /// Velocity of a launched entity at the end of any physics step, which
+    /// matches the velocity integration gives it there
+    /// @param i index of the entity
+    /// @param t physics time at the end of the step
+    /// @param dt physics timestep
+    Vector2 velocity_at(size_t i, double t, double dt) const;
+
+    /// Send an entity off on a new parabola from the end of a physics step,
+    /// as if it had been launched from there. Integrated entities must
+    /// already have been advanced to the end of the step.
+    /// @param i index of the entity
+    /// @param t physics time at the end of the step
+    /// @param dt physics timestep
+    /// @param pos position to carry on from
+    /// @param velocity velocity to carry on with
+    void redirect(size_t i, double t, double dt, Vector2 pos, Vector2 velocity);
+
+    /// Physics state after the last physics step
+    std::vector<float> x, y, vx, vy;
+    /// Physics state before the last physics step
+    std::vector<float> prev_x, prev_y, prev_vx, prev_vy;
+    /// Acceleration accumulated from forces for the next physics step
+    std::vector<float> ax, ay;
+    /// Physics time, position, and velocity of the parabola an entity follows
+    /// from the moment it was launched, which ballistic entities are drawn
+    /// from
+    std::vector<double> launch_t;
+    std::vector<float> launch_x, launch_y, launch_vx, launch_vy;
+    /// Interpolated position and horizontal velocity for this frame
+    std::vector<float> draw_x, draw_y, draw_vx;
+    std::vector<float> radius;
+    std::vector<float> mass;
+    std::vector<SpriteId> sprite;
+    std::vector<EntityType> type;
+    /// Combination of EntityFlags
+    std::vector<uint8_t> flags;
+    /// Slot each entity's handles refer to
+    std::vector<uint32_t> slot;
+
+    /// Whether entities follow the closed-form parabola from where they were
+    /// launched instead of being integrated every physics step. Only change it
+    /// while there are no entities.
+    bool ballistic = false;
+
+   private:
+    /// Index of the entity in each slot
+    std::vector<uint32_t> slot_index;
+    /// Number of times each slot has been reused
+    std::vector<uint32_t> generations;
+    /// Slots with no entity in them
+    std::vector<uint32_t> free_slots;
+    PoolStats pool_stats[ENTITY_POOLS];
+
+    /// Pool an entity belongs to
+    /// @param type what the entity is
+    static EntityPool pool(EntityType type) {
+        return type == EntityType::Shard ? EntityPool::Shard
+                                         : EntityPool::Throwable;
+    }
+
+    /// Call a function on every column
+    /// @param f function taking a reference to a column
+    template <typename F>
+    void for_each_column(F f) {
+        f(x), f(y), f(vx), f(vy);
+        f(prev_x), f(prev_y), f(prev_vx), f(prev_vy);
+        f(ax), f(ay);
+        f(launch_t), f(launch_x), f(launch_y), f(launch_vx), f(launch_vy);
+        f(draw_x), f(draw_y), f(draw_vx);
+        f(radius), f(mass), f(sprite), f(type), f(flags);
+        f(slot);
+    }
+};
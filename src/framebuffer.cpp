@@ -0,0 +1,258 @@
+/// @file framebuffer.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of the offscreen render target
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "FEHLCD.h"
+
+#include "framebuffer.h"
+#include "image.h"
+#include "ui.h"
+
+Framebuffer::DirtyRows::DirtyRows(int height)
+    : first(height, INT_MAX), last(height, INT_MIN) {}
+
+void Framebuffer::DirtyRows::fill(int width) {
+    std::fill(first.begin(), first.end(), 0);
+    std::fill(last.begin(), last.end(), width);
+}
+
+void Framebuffer::DirtyRows::reset() {
+    std::fill(first.begin(), first.end(), INT_MAX);
+    std::fill(last.begin(), last.end(), INT_MIN);
+}
+
+bool Framebuffer::Text::operator==(const Text& b) const {
+    return x == b.x && y == b.y && color == b.color && text == b.text;
+}
+
+Framebuffer::Framebuffer(int width, int height)
+    : w(width),
+      h(height),
+      color(0),
+      back((size_t)width * height),
+      front((size_t)width * height),
+      changed(height),
+      drawn(height),
+      uploaded(height),
+      background(nullptr) {
+    invalidate();
+}
+
+void Framebuffer::mark_dirty(int x1, int y1, int x2, int y2) {
+    x1 = std::max(x1, 0);
+    x2 = std::min(x2, w);
+    y1 = std::max(y1, 0);
+    y2 = std::min(y2, h);
+    if (x1 >= x2)
+        return;
+
+    for (int y = y1; y < y2; y++) {
+        changed.extend(y, x1, x2);
+        drawn.extend(y, x1, x2);
+    }
+}
+
+void Framebuffer::clear(uint32_t color) {
+    std::fill(back.begin(), back.end(), color);
+    changed.fill(w);
+    drawn.fill(w);
+    background = nullptr;
+}
+
+void Framebuffer::draw_background(const Image& background) {
+    if (&background != this->background) {
+        for (int y = 0; y < h; y++)
+            std::memcpy(row(y), background.row(y), w * sizeof(uint32_t));
+        changed.fill(w);
+    } else {
+        // everything outside of what was drawn is still the background
+        for (int y = 0; y < h; y++) {
+            int x1 = drawn.first[y];
+            int x2 = drawn.last[y];
+            if (x1 >= x2)
+                continue;
+
+            std::memcpy(row(y) + x1, background.row(y) + x1,
+                        (x2 - x1) * sizeof(uint32_t));
+            changed.extend(y, x1, x2);
+        }
+    }
+
+    drawn.reset();
+    this->background = &background;
+}
+
+void Framebuffer::draw_horizontal_line(int y, int x1, int x2) {
+    if (x2 < x1)
+        std::swap(x1, x2);
+
+    if (y < 0 || y >= h)
+        return;
+
+    x1 = std::max(x1, 0);
+    x2 = std::min(x2, w - 1);
+    if (x1 > x2)
+        return;
+
+    std::fill(row(y) + x1, row(y) + x2 + 1, color);
+    changed.extend(y, x1, x2 + 1);
+    drawn.extend(y, x1, x2 + 1);
+}
+
+void Framebuffer::draw_vertical_line(int x, int y1, int y2) {
+    if (y2 < y1)
+        std::swap(y1, y2);
+
+    if (x < 0 || x >= w)
+        return;
+
+    y1 = std::max(y1, 0);
+    y2 = std::min(y2, h - 1);
+    for (int y = y1; y <= y2; y++) {
+        row(y)[x] = color;
+        changed.extend(y, x, x + 1);
+        drawn.extend(y, x, x + 1);
+    }
+}
+
+void Framebuffer::fill_rectangle(int x, int y, int width, int height) {
+    for (int j = y; j < y + height; j++)
+        draw_horizontal_line(j, x, x + width - 1);
+}
+
+void Framebuffer::draw_rectangle(int x, int y, int width, int height) {
+    draw_horizontal_line(y, x, x + width);
+    draw_horizontal_line(y + height, x, x + width);
+    draw_vertical_line(x, y, y + height);
+    draw_vertical_line(x + width, y, y + height);
+}
+
+void Framebuffer::write_at(const std::string& text, int x, int y) {
+    texts.push_back({text, x, y, color});
+}
+
+void Framebuffer::write_at(int value, int x, int y) {
+    write_at(std::to_string(value), x, y);
+}
+
+void Framebuffer::erase_text(int x, int y, int width, int height) {
+    texts.erase(std::remove_if(texts.begin(), texts.end(),
+                               [=](const Text& text) {
+                                   int text_width = text.text.length() *
+                                                    FONT_GLYPH_WIDTH;
+                                   return text.x < x + width &&
+                                          x < text.x + text_width &&
+                                          text.y < y + height &&
+                                          y < text.y + (int)FONT_GLYPH_HEIGHT;
+                               }),
+                texts.end());
+}
+
+void Framebuffer::invalidate() {
+    // make every pixel differ from the frame being drawn
+    std::transform(back.begin(), back.end(), front.begin(),
+                   [](uint32_t color) { return ~color; });
+    changed.fill(w);
+    presented_texts.clear();
+}
+
+void Framebuffer::invalidate_text(const Text& text) {
+    int x1 = std::max(text.x, 0);
+    int x2 = std::min(text.x + (int)(text.text.length() * FONT_GLYPH_WIDTH), w);
+    int y1 = std::max(text.y, 0);
+    int y2 = std::min(text.y + (int)FONT_GLYPH_HEIGHT, h);
+
+    for (int y = y1; y < y2; y++) {
+        for (int x = x1; x < x2; x++) {
+            size_t i = (size_t)y * w + x;
+            front[i] = ~back[i];
+        }
+        changed.extend(y, x1, x2);
+    }
+}
+
+bool Framebuffer::text_uploaded_over(const Text& text) const {
+    int x1 = text.x;
+    int x2 = text.x + (int)(text.text.length() * FONT_GLYPH_WIDTH);
+    int y1 = std::max(text.y, 0);
+    int y2 = std::min(text.y + (int)FONT_GLYPH_HEIGHT, h);
+
+    for (int y = y1; y < y2; y++) {
+        if (uploaded.first[y] < x2 && uploaded.last[y] > x1)
+            return true;
+    }
+
+    return false;
+}
+
+bool Framebuffer::present() {
+    // text from the last frame was written straight to the LCD, so whatever
+    // is underneath text which went away has to be uploaded again
+    for (const Text& text : presented_texts) {
+        if (std::find(texts.begin(), texts.end(), text) == texts.end())
+            invalidate_text(text);
+    }
+
+    bool sent = false;
+    uploaded.reset();
+
+    for (int y = 0; y < h; y++) {
+        int x = changed.first[y];
+        int end = changed.last[y];
+        uint32_t* src = row(y);
+        uint32_t* dst = front.data() + (size_t)y * w;
+
+        while (x < end) {
+            // skip pixels the LCD already shows
+            while (x < end && src[x] == dst[x])
+                x++;
+
+            // upload each run of a single color as one line, the most the
+            // LCD can take in one call since it only draws solid shapes
+            while (x < end && src[x] != dst[x]) {
+                int run = x + 1;
+                while (run < end && src[run] == src[x])
+                    run++;
+
+                LCD.SetFontColor(src[x]);
+                if (run - x == 1)
+                    LCD.DrawPixel(x, y);
+                else
+                    LCD.DrawHorizontalLine(y, x, run - 1);
+
+                std::fill(dst + x, dst + run, src[x]);
+                uploaded.extend(y, x, run);
+                sent = true;
+                x = run;
+            }
+        }
+    }
+
+    // write text which is new or had pixels uploaded on top of it
+    for (const Text& text : texts) {
+        bool on_screen = std::find(presented_texts.begin(),
+                                   presented_texts.end(),
+                                   text) != presented_texts.end();
+        if (on_screen && !text_uploaded_over(text))
+            continue;
+
+        LCD.SetFontColor(text.color);
+        LCD.WriteAt(text.text.c_str(), text.x, text.y);
+        sent = true;
+    }
+
+    std::swap(texts, presented_texts);
+    texts.clear();
+    changed.reset();
+
+    if (sent)
+        LCD.Update();
+
+    return sent;
+}
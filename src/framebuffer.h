@@ -0,0 +1,208 @@
+#pragma once
+
+/// @file framebuffer.h
+/// @author Mark Bundschuh
+/// @brief Offscreen software render target which is presented to the LCD once
+/// per frame
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blit.h"
+#include "image.h"
+#include "ui.h"
+
+/// Offscreen render target. Everything in the game draws into this with plain
+/// memory writes, and the result is uploaded to the LCD once per frame.
+///
+/// Every draw call records which part of each row it touched. This lets a
+/// frame start from a cached background by restoring only what was drawn over
+/// last frame, and lets present only look at (and upload) rows and columns
+/// which could have changed.
+class Framebuffer {
+   public:
+    /// Create a framebuffer
+    /// @param width width in pixels
+    /// @param height height in pixels
+    Framebuffer(int width, int height);
+
+    /// Width in pixels of the framebuffer
+    int width() const { return w; }
+
+    /// Height in pixels of the framebuffer
+    int height() const { return h; }
+
+    /// Retrieve a row of the framebuffer for direct writing. Anything written
+    /// this way must be reported with mark_dirty.
+    /// @param y row index in [0, height)
+    /// @return pointer to the first of width() contiguous 0xAARRGGBB pixels
+    uint32_t* row(int y) { return back.data() + (size_t)y * w; }
+
+    /// Report a rectangle which was written to directly through row
+    /// @param x1 first column (inclusive)
+    /// @param y1 first row (inclusive)
+    /// @param x2 last column (exclusive)
+    /// @param y2 last row (exclusive)
+    void mark_dirty(int x1, int y1, int x2, int y2);
+
+    /// Set the color of subsequent draw calls, the same as LCD.SetFontColor
+    /// @param color color as 0xAARRGGBB or 0xRRGGBB
+    void set_color(uint32_t color) { this->color = color; }
+
+    /// Draw a pixel in the current color, ignoring out of bounds pixels
+    /// @param x screenspace x coordinate
+    /// @param y screenspace y coordinate
+    void draw_pixel(int x, int y) {
+        if ((unsigned)x < (unsigned)w && (unsigned)y < (unsigned)h) {
+            back[(size_t)y * w + x] = color;
+            changed.extend(y, x, x + 1);
+            drawn.extend(y, x, x + 1);
+        }
+    }
+
+    /// Fill the entire framebuffer with a color
+    /// @param color color to fill with
+    void clear(uint32_t color = 0);
+
+    /// Start a frame from a full screen background image. If it is the same
+    /// background as last time, only what was drawn over it since then is
+    /// restored.
+    /// @param background opaque image the size of the framebuffer
+    void draw_background(const Image& background);
+
+    /// Draw a horizontal line in the current color, clipped to the screen
+    /// @param y screenspace y coordinate of the line
+    /// @param x1 first x coordinate (inclusive)
+    /// @param x2 last x coordinate (inclusive)
+    void draw_horizontal_line(int y, int x1, int x2);
+
+    /// Draw a vertical line in the current color, clipped to the screen
+    /// @param x screenspace x coordinate of the line
+    /// @param y1 first y coordinate (inclusive)
+    /// @param y2 last y coordinate (inclusive)
+    void draw_vertical_line(int x, int y1, int y2);
+
+    /// Fill a rectangle in the current color, clipped to the screen
+    /// @param x x coordinate of the upper left corner
+    /// @param y y coordinate of the upper left corner
+    /// @param width width in pixels
+    /// @param height height in pixels
+    void fill_rectangle(int x, int y, int width, int height);
+
+    /// Draw the outline of a rectangle in the current color, the same as
+    /// LCD.DrawRectangle
+    /// @param x x coordinate of the upper left corner
+    /// @param y y coordinate of the upper left corner
+    /// @param width width in pixels
+    /// @param height height in pixels
+    void draw_rectangle(int x, int y, int width, int height);
+
+    /// Write text in the current color on top of the frame. The LCD owns the
+    /// font, so text is queued and written after the pixels are uploaded.
+    /// @param text text to write
+    /// @param x x coordinate of the upper left corner of the text
+    /// @param y y coordinate of the upper left corner of the text
+    void write_at(const std::string& text, int x, int y);
+
+    /// Write a number in the current color on top of the frame
+    /// @param value number to write
+    /// @param x x coordinate of the upper left corner of the text
+    /// @param y y coordinate of the upper left corner of the text
+    void write_at(int value, int x, int y);
+
+    /// Drop text queued so far this frame which overlaps a rectangle, for
+    /// drawing over it
+    /// @param x x coordinate of the upper left corner
+    /// @param y y coordinate of the upper left corner
+    /// @param width width of the rectangle
+    /// @param height height of the rectangle
+    void erase_text(int x, int y, int width, int height);
+
+    /// Upload the frame to the LCD. Only pixels which differ from what the LCD
+    /// is already showing are sent, as runs of a single color, and text is
+    /// only written again if it changed or was drawn over.
+    ///
+    /// Runs are as coarse as the upload can get. FEHLCD (the Proteus, the
+    /// simulator, and the headless stand-in) has no call which takes a buffer
+    /// of pixels: everything goes through SetFontColor followed by a solid
+    /// DrawPixel, line or rectangle, so a row of differing colors costs at
+    /// least one call per color change however it is batched.
+    /// @return whether anything was sent to the LCD
+    bool present();
+
+    /// Forget what the LCD is showing so the next present uploads everything.
+    /// Call this after drawing to the LCD directly.
+    void invalidate();
+
+   private:
+    /// Text queued to be written over the frame
+    struct Text {
+        std::string text;
+        int x, y;
+        uint32_t color;
+
+        bool operator==(const Text& b) const;
+    };
+
+    /// Horizontal extent of the area touched in every row
+    class DirtyRows {
+       public:
+        /// Create a tracker with every row clean
+        /// @param height number of rows
+        DirtyRows(int height);
+
+        /// Grow the touched area of a row
+        /// @param y row
+        /// @param x1 first column (inclusive)
+        /// @param x2 last column (exclusive)
+        void extend(int y, int x1, int x2) {
+            if (x1 < first[y])
+                first[y] = x1;
+            if (x2 > last[y])
+                last[y] = x2;
+        }
+
+        /// Mark every row as completely touched
+        /// @param width number of columns
+        void fill(int width);
+
+        /// Mark every row as clean
+        void reset();
+
+        /// First touched column of each row (inclusive)
+        std::vector<int> first;
+        /// Last touched column of each row (exclusive), less than or equal to
+        /// first if the row is clean
+        std::vector<int> last;
+    };
+
+    /// Force pixels under the area of some text to be uploaded
+    /// @param text text which was written to the LCD
+    void invalidate_text(const Text& text);
+
+    /// Check if text overlaps an area that was uploaded this present
+    /// @param text text to check
+    bool text_uploaded_over(const Text& text) const;
+
+    int w, h;
+    uint32_t color;
+    /// Frame currently being drawn
+    PixelBuffer back;
+    /// Copy of what the LCD is showing, excluding text
+    PixelBuffer front;
+    /// Area which changed since the last present
+    DirtyRows changed;
+    /// Area drawn over since the background was last restored
+    DirtyRows drawn;
+    /// Area sent to the LCD during the current present
+    DirtyRows uploaded;
+    /// Background the frame was last started from
+    const Image* background;
+    std::vector<Text> texts;
+    std::vector<Text> presented_texts;
+};
+
+/// Global variable to hold the framebuffer that the game renders into
+inline auto framebuffer = std::make_shared<Framebuffer>(LCD_WIDTH, LCD_HEIGHT);
@@ -6,18 +6,135 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <memory>
+#include <string>
 
 #include "FEHLCD.h"
 #include "FEHUtility.h"
 
+#include "config.h"
 #include "endgame.h"
+#include "framebuffer.h"
 #include "game.h"
+#include "kinds.h"
 #include "menu.h"
+#include "profiler.h"
+#include "tasks.h"
 #include "throwable.h"
 #include "ui.h"
 #include "util.h"
 
+#define PI 3.14159265358979323846
+
+/// Angle a thrown object is drawn at, spinning faster the faster it moves
+/// sideways
+/// @param t physics time
+/// @param vx horizontal velocity of the object
+static float spin(double t, float vx) {
+    return t * PI * std::clamp(vx / 10.0f, -2.0f, 2.0f);
+}
+
+/// Pixels added around what is drawn of every object when culling, since
+/// rotating a sprite can move its pixels a little past its reach
+static const float CULL_MARGIN = 1;
+
+/// Distance the ring drawn around bombs is from their edge
+static const float BOMB_RING = 5;
+
+/// How the particles of an effect fly out from where it happens
+struct Burst {
+    /// Range of speeds in pixels per second, in a random direction
+    float min_speed, max_speed;
+    /// Downward acceleration in pixels per second squared
+    float gravity;
+    /// Range of radii in pixels
+    float min_radius, max_radius;
+    /// Range of lifetimes in seconds
+    float min_life, max_life;
+};
+
+/// Fire and smoke of a bomb going off, spreading out about as far as the
+/// ring of circles it used to be drawn with
+static const Burst EXPLOSION = {10, 120, -20, 2, 12, 0.3, 0.85};
+/// Drops of juice from a cut fruit, which fall
+static const Burst JUICE = {40, 140, 437.5, 1, 3, 0.3, 0.6};
+/// Quick sparks where a fruit is cut
+static const Burst SPARKS = {150, 300, 0, 1, 1, 0.08, 0.2};
+
+/// Colors the explosion of a bomb is made of
+static const uint32_t EXPLOSION_COLORS[] = {DARKGOLDENROD, RED, GRAY,
+                                            FIREBRICK};
+/// Colors sparks are made of
+static const uint32_t SPARK_COLORS[] = {WHITE, 0xFFF3A0};
+
+/// Emit the particles of an effect
+/// @param particles particles to add to
+/// @param pos screenspace position the effect starts from
+/// @param count number of particles
+/// @param burst how they fly out
+/// @param colors colors to pick from at random
+/// @param color_count number of colors
+static void emit_burst(Particles& particles,
+                       Vector2 pos,
+                       size_t count,
+                       const Burst& burst,
+                       const uint32_t* colors,
+                       size_t color_count) {
+    for (size_t n = 0; n < count; n++) {
+        float angle = rand_range(0, 2 * PI);
+        float speed = rand_range(burst.min_speed, burst.max_speed);
+        size_t color = std::min((size_t)rand_range(0, color_count),
+                                color_count - 1);
+        Vector2 velocity(std::cos(angle) * speed, std::sin(angle) * speed);
+        if (!particles.emit(pos, velocity, burst.gravity,
+                            rand_range(burst.min_radius, burst.max_radius),
+                            colors[color],
+                            rand_range(burst.min_life, burst.max_life)))
+            return;
+    }
+}
+
+/// Seconds the screen takes to wipe to black when the game ends
+static const double WIPE_DURATION = 0.5;
+
+/// Wipes the screen to black from the top down, over the game carrying on
+/// underneath, and then shows the end screen
+class EndWipe : public Task {
+   public:
+    /// Constructor
+    /// @param points number of points scored in the game
+    EndWipe(uint32_t points) : points(points) {}
+
+    bool resume(double now) override {
+        TASK_BEGIN();
+        start = now;
+        while (now - start < WIPE_DURATION) {
+            wipe(LCD_HEIGHT * (now - start) / WIPE_DURATION);
+            TASK_NEXT_FRAME();
+        }
+        wipe(LCD_HEIGHT);
+
+        // switch scenes and show keyboard/end game screen
+        end_game->end(points);
+        scheduler->change_scene(end_game);
+        TASK_END();
+    }
+
+   private:
+    /// Black out rows from the top of the screen
+    /// @param rows number of rows
+    static void wipe(int rows) {
+        framebuffer->set_color(BLACK);
+        framebuffer->fill_rectangle(0, 0, LCD_WIDTH, rows);
+        framebuffer->erase_text(0, 0, LCD_WIDTH, rows);
+    }
+
+    uint32_t points;
+    /// Time of the frame the wipe started in
+    double start;
+};
+
 /// @author Mark Bundschuh
 Game::Game() {
     background = image_repository->load_image("assets/background-menu.png");
@@ -25,79 +142,296 @@ Game::Game() {
 
 /// @author Mark Bundschuh
 void Game::start(float bomb_probability, float multiplier) {
-    apples.clear();
-    bananas.clear();
-    bombs.clear();
-    oranges.clear();
-    cherries.clear();
-    strawberries.clear();
-    pineapples.clear();
-    fruit_shards.clear();
+    entities.clear();
+    entities.reserve(config.throwable_pool_size, config.shard_pool_size);
+    entities.ballistic = config.ballistic_physics;
+    particles.clear();
+    particles.reserve(config.particle_pool_size);
+    exploding = false;
+    ending = false;
     this->bomb_probability = bomb_probability;
     this->multiplier = multiplier;
     points = 0;
     combo = 0;
     t = 0;
-    time_started = TimeNow();
+    last_dt = 0;
+    knife_path.clear();
+    sweep.clear();
+    spawn_rate = SPAWN_RATE;
+    timed = true;
+    knife_enabled = true;
 }
 
 /// @author Mark Bundschuh
 void Game::end() {
-    // screen wipe
-    LCD.SetFontColor(BLACK);
-    for (uint64_t i = 0; i < LCD_HEIGHT; i += 2) {
-        LCD.DrawHorizontalLine(i, 0, LCD_WIDTH);
-        LCD.DrawHorizontalLine(i + 1, 0, LCD_WIDTH);
-        LCD.Update();
-    }
+    // the wipe plays out a frame at a time, with nothing more thrown or cut
+    // in the meantime
+    ending = true;
+    scheduler->start(std::make_unique<EndWipe>(points));
+}
+
+/// @author Mark Bundschuh
+void Game::cut_with_knife(double t1, double t2) {
+    bool packed = false;
+    for (size_t s = 1; s < knife_path.size(); s++) {
+        // the knife cuts between samples it was held down for, over the part
+        // of the time between them that is in this step
+        const KnifeSample& a = knife_path[s - 1];
+        const KnifeSample& b = knife_path[s];
+        if (!a.pressed || !b.pressed || a.t >= b.t || b.t <= t1 || a.t >= t2)
+            continue;
 
-    // switch scenes and show keyboard/end game screen
-    end_game->end(points);
-    current_scene = end_game;
+        // Only once the knife is known to be down are the fruits and bombs
+        // gathered up, with the shards of anything cut this step left out.
+        // Each is found by a circle covering all of its sprite, and then
+        // checked against the sprite itself.
+        if (!packed) {
+            swept.clear();
+            swept_x1.clear();
+            swept_y1.clear();
+            swept_x2.clear();
+            swept_y2.clear();
+            swept_radius.clear();
+            for (size_t i = 0; i < entities.size(); i++) {
+                if (entities.type[i] == EntityType::Shard ||
+                    (entities.flags[i] & ENTITY_REMOVED))
+                    continue;
+
+                Vector2 p1 = entities.position_at(i, t1);
+                Vector2 p2 = entities.position_at(i, t2);
+                swept.push_back(i);
+                swept_x1.push_back(p1.x);
+                swept_y1.push_back(p1.y);
+                swept_x2.push_back(p2.x);
+                swept_y2.push_back(p2.y);
+                swept_radius.push_back(
+                    image_repository->sprite(entities.sprite[i]).reach());
+            }
+            grid.build(swept_x1.data(), swept_y1.data(), swept_x2.data(),
+                       swept_y2.data(), swept_radius.data(), swept.size(),
+                       config.knife_grid_cell_size);
+            packed = true;
+        }
+
+        // where the knife is at the start and end of that part, and how far
+        // through the step they are
+        double from = std::max(a.t, t1);
+        double to = std::min(b.t, t2);
+        Vector2 k1 = a.position + (b.position - a.position) *
+                                      (float)((from - a.t) / (b.t - a.t));
+        Vector2 k2 = a.position + (b.position - a.position) *
+                                      (float)((to - a.t) / (b.t - a.t));
+        float u1 = (from - t1) / (t2 - t1);
+        float u2 = (to - t1) / (t2 - t1);
+
+        // a hit is somewhere along the knife's path, inside the box around
+        // the path of what it hit, so the grid finds it from the knife alone
+        grid.query(k1, k2, near_knife);
+
+        size_t n = 0;
+        near_x1.resize(near_knife.size());
+        near_y1.resize(near_knife.size());
+        near_x2.resize(near_knife.size());
+        near_y2.resize(near_knife.size());
+        near_radius.resize(near_knife.size());
+        for (uint32_t k : near_knife) {
+            if (entities.flags[swept[k]] & ENTITY_REMOVED)
+                continue;
+
+            float dx = swept_x2[k] - swept_x1[k];
+            float dy = swept_y2[k] - swept_y1[k];
+            near_knife[n] = k;
+            near_x1[n] = swept_x1[k] + dx * u1;
+            near_y1[n] = swept_y1[k] + dy * u1;
+            near_x2[n] = swept_x1[k] + dx * u2;
+            near_y2[n] = swept_y1[k] + dy * u2;
+            near_radius[n] = swept_radius[k];
+            n++;
+        }
+        near_hits.resize((n + 63) / 64);
+        collide_swept_circles(k1, k2, near_x1.data(), near_y1.data(),
+                              near_x2.data(), near_y2.data(),
+                              near_radius.data(), n, near_hits.data());
+
+        for (size_t k = 0; k < n; k++) {
+            if (!(near_hits[k / 64] >> (k % 64) & 1))
+                continue;
+            size_t i = swept[near_knife[k]];
+
+            // The knife's path as seen from the object, against the same
+            // pre-rotated sprite that is drawn for it at the start of that
+            // part of the step, whose angle is quantized and whose edges
+            // RotSprite has redrawn
+            Vector2 p1 = k1 - Vector2(near_x1[k], near_y1[k]);
+            Vector2 p2 = k2 - Vector2(near_x2[k], near_y2[k]);
+            const Image& image = image_repository->rotated(
+                image_repository->sprite(entities.sprite[i]),
+                spin(from, entities.launch_vx[i]));
+            if (!image.segment_hits(p1, p2, 0))
+                continue;
+
+            // each kind's cut is stamped out and inlined here
+            bool keep_cutting =
+                ThrowableKinds::visit(entities.type[i], [&](auto kind) {
+                    using Kind = decltype(kind);
+                    return Kind::Cut::template cut<Kind>(*this, i);
+                });
+            if (!keep_cutting)
+                return;
+        }
+    }
 }
 
 /// @author Mark Bundschuh
-template <typename T>
-void collision(Vector2 p1, Vector2 p2, T& a) {
-    std::for_each(a.begin(), a.end(),
-                  [p1, p2](auto& b) { b->collision(p1, p2); });
+void Game::retire_lost(double t) {
+    for (size_t i = 0; i < entities.size(); i++) {
+        if (entities.flags[i] & ENTITY_REMOVED)
+            continue;
+
+        // as far as anything drawn of it reaches, including a bomb's ring
+        float reach = image_repository->sprite(entities.sprite[i]).reach();
+        if (entities.type[i] == EntityType::Bomb)
+            reach = std::max(reach, entities.radius[i] + BOMB_RING);
+
+        // gravity only ever pulls down, so past the bottom and falling, or
+        // past a side and heading away from it, an object's own parabola only
+        // takes it further away. Only a collision could bring it back, and
+        // it is gone before the next one.
+        Vector2 p = entities.position_at(i, t);
+        Vector2 v = entities.velocity_at(i, t, last_dt);
+        bool below = p.y - reach > LCD_HEIGHT && v.y >= 0;
+        bool left = p.x + reach < 0 && v.x <= 0;
+        bool right = p.x - reach > LCD_WIDTH && v.x >= 0;
+        if (below || left || right)
+            entities.flags[i] |= ENTITY_REMOVED;
+    }
 }
 
 /// @author Mark Bundschuh
-void Game::collide_with_knife(Vector2 p1, Vector2 p2) {
-    collision(p1, p2, apples);
-    collision(p1, p2, bananas);
-    collision(p1, p2, oranges);
-    collision(p1, p2, cherries);
-    collision(p1, p2, strawberries);
-    collision(p1, p2, pineapples);
-    collision(p1, p2, bombs);
+bool Game::collide_objects(double t, double dt) {
+    size_t n = entities.size();
+    body_x.resize(n);
+    body_y.resize(n);
+    body_vx.resize(n);
+    body_vy.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        Vector2 p = entities.position_at(i, t);
+        body_x[i] = p.x;
+        body_y[i] = p.y;
+    }
+    sweep.update(entities, body_x.data(), body_y.data(), touching);
+
+    bounced.assign(n, 0);
+    bounces.clear();
+    for (EntityPair pair : touching) {
+        uint32_t a = pair.a, b = pair.b;
+        float dx = body_x[b] - body_x[a];
+        float dy = body_y[b] - body_y[a];
+        float distance_squared = dx * dx + dy * dy;
+        float reach = entities.radius[a] + entities.radius[b];
+
+        // objects exactly on top of each other have no direction to bounce in
+        if (distance_squared >= reach * reach || distance_squared == 0)
+            continue;
+
+        // velocities are only worked out for objects that bounce
+        for (uint32_t i : {a, b}) {
+            if (!bounced[i]) {
+                Vector2 v = entities.velocity_at(i, t, dt);
+                body_vx[i] = v.x;
+                body_vy[i] = v.y;
+                bounced[i] = 1;
+                bounces.push_back(i);
+            }
+        }
+
+        // push them apart along the line between their centers, the lighter
+        // one further, then bounce them off each other if they are closing
+        float distance = std::sqrt(distance_squared);
+        float nx = dx / distance;
+        float ny = dy / distance;
+        float inv_a = 1 / entities.mass[a];
+        float inv_b = 1 / entities.mass[b];
+        float push = (reach - distance) / (inv_a + inv_b);
+        body_x[a] -= nx * push * inv_a;
+        body_y[a] -= ny * push * inv_a;
+        body_x[b] += nx * push * inv_b;
+        body_y[b] += ny * push * inv_b;
+
+        float closing = (body_vx[b] - body_vx[a]) * nx +
+                        (body_vy[b] - body_vy[a]) * ny;
+        if (closing >= 0)
+            continue;
+
+        float impulse =
+            -(1 + config.object_restitution) * closing / (inv_a + inv_b);
+        body_vx[a] -= nx * impulse * inv_a;
+        body_vy[a] -= ny * impulse * inv_a;
+        body_vx[b] += nx * impulse * inv_b;
+        body_vy[b] += ny * impulse * inv_b;
+    }
+    return !bounces.empty();
 }
 
 /// @author Mark Bundschuh
-template <typename T>
-void physics_update_foreach(double t, double dt, T& a) {
-    std::for_each(a.begin(), a.end(),
-                  [t, dt](auto& b) { b->physics_update(t, dt); });
+template <typename Kind>
+bool SliceInHalf::cut(Game& game, size_t i) {
+    game.slice(i, Kind::left, Kind::right, Kind::juice);
+    return true;
 }
 
 /// @author Mark Bundschuh
-template <typename T>
-void update_foreach(double alpha, T& a) {
-    std::for_each(a.begin(), a.end(), [alpha](auto& b) { b->update(alpha); });
+template <typename Kind>
+bool Explode::cut(Game& game, size_t i) {
+    game.explode(i);
+    return false;
 }
 
 /// @author Mark Bundschuh
-template <typename T>
-void remove_if_foreach(T& a) {
-    a.erase(std::remove_if(a.begin(), a.end(),
-                           [](auto& b) { return b->get_should_be_removed(); }),
-            a.end());
+void Game::slice(size_t i, SpriteId left, SpriteId right, uint32_t juice) {
+    entities.flags[i] |= ENTITY_REMOVED;
+
+    // the shards fly off from where the fruit is at the end of the step
+    double end = t + last_dt;
+    Vector2 position = entities.position_at(i, end);
+    float radius = entities.radius[i];
+    float mass = entities.mass[i];
+
+    Vector2 force_left = {rand_range(-60000, -120000),
+                          rand_range(-120000, 120000)};
+    entities.launch(EntityType::Shard, left, radius, mass, position,
+                    force_left, end, last_dt);
+
+    Vector2 force_right = {-force_left.x, -force_left.y};
+    entities.launch(EntityType::Shard, right, radius, mass, position,
+                    force_right, end, last_dt);
+
+    emit_burst(particles, position, config.juice_particles, JUICE, &juice, 1);
+    emit_burst(particles, position, config.spark_particles, SPARKS,
+               SPARK_COLORS, std::size(SPARK_COLORS));
+
+    points += multiplier * std::log2(combo + 2);
+    combo++;
+    combo_time = t;
+}
+
+/// @author John Ulm and Mark Bundschuh
+void Game::explode(size_t bomb) {
+    entities.flags[bomb] |= ENTITY_REMOVED;
+
+    // the explosion plays out in the particles while everything else carries
+    // on, and the game ends once it is over
+    Vector2 position = entities.position_at(bomb, t + last_dt);
+    particles.emit(position, Vector2(), 0, 10, INDIANRED, 0.2);
+    emit_burst(particles, position, config.explosion_particles, EXPLOSION,
+               EXPLOSION_COLORS, std::size(EXPLOSION_COLORS));
+
+    exploding = true;
+    explosion_end = t + last_dt + EXPLOSION_DURATION;
 }
 
 /// @author John Ulm
-void Game::physics_update(double t, double dt) {
-    // random generation of fruits
+void Game::spawn() {
     float randX = rand_range(20, LCD_WIDTH - 20);
     float randForce = rand_range(-50, 80000);
 
@@ -107,82 +441,144 @@ void Game::physics_update(double t, double dt) {
     Vector2 pos = {randX, LCD_HEIGHT + 20};
     Vector2 first_force = {randForce, rand_range(-360000, -260000)};
 
-    // There is a 1.5% chance every physics update (which keeps it in real
-    // time) to spawn any item. There is a bomb_probability (difficulty level)
-    // chance of spawning a bomb and if the item turns out to not be a bomb it
-    // will uniformly randomly select from one of the five fruit to spawn.
-    if (rand_range(0, 1) <= 0.015) {
-        if (rand_range(0, 1) <= bomb_probability) {
-            auto bomb = std::make_unique<Bomb>(pos);
-            bomb->add_force(first_force);
-            bombs.push_back(std::move(bomb));
-        } else {
-            uint32_t choice = (uint32_t)rand_range(0, 5 + 1);
-
-            if (choice == 0) {
-                auto apple = std::make_unique<Apple>(pos);
-                apple->add_force(first_force);
-                apples.push_back(std::move(apple));
-            } else if (choice == 1) {
-                auto banana = std::make_unique<Bananas>(pos);
-                banana->add_force(first_force);
-                bananas.push_back(std::move(banana));
-            } else if (choice == 2) {
-                auto orange = std::make_unique<Orange>(pos);
-                orange->add_force(first_force);
-                oranges.push_back(std::move(orange));
-            } else if (choice == 3) {
-                auto cherry = std::make_unique<Cherries>(pos);
-                cherry->add_force(first_force);
-                cherries.push_back(std::move(cherry));
-            } else if (choice == 4) {
-                auto strawberry = std::make_unique<Strawberry>(pos);
-                strawberry->add_force(first_force);
-                strawberries.push_back(std::move(strawberry));
-            } else if (choice == 5) {
-                auto pineapple = std::make_unique<Pineapple>(pos);
-                pineapple->add_force(first_force);
-                pineapples.push_back(std::move(pineapple));
+    // There is a bomb_probability (difficulty level) chance of spawning a bomb
+    // and if the item turns out to not be a bomb it will uniformly randomly
+    // select from one of the fruit to spawn.
+    EntityType type;
+    if (rand_range(0, 1) <= bomb_probability) {
+        type = EntityType::Bomb;
+    } else {
+        size_t choice = (size_t)rand_range(0, ThrowableKinds::fruits);
+
+        // rand_range includes its upper bound, which throws nothing
+        if (choice >= ThrowableKinds::fruits)
+            return;
+        type = ThrowableKinds::fruit(choice);
+    }
+
+    ThrowableKinds::visit(type, [&](auto kind) {
+        using Kind = decltype(kind);
+        return entities.launch(Kind::type, Kind::whole, Kind::radius,
+                               Kind::mass, pos, first_force, t, last_dt);
+    });
+}
+
+/// @author Mark Bundschuh
+size_t Game::object_count() const {
+    return entities.size();
+}
+
+/// @author John Ulm
+void Game::physics_update(double t, double dt) {
+    physics_steps(t, dt, 1);
+}
+
+/// @author Mark Bundschuh
+void Game::physics_steps(double t, double dt, uint32_t steps) {
+    // Objects are integrated several steps at a time, only stopping to catch
+    // everything up to the step where new objects are thrown so that they
+    // start from the same step as everything else
+    last_dt = dt;
+    uint32_t integrated = 0;
+
+    // the touch was read at a time on the main loop's clock, which runs ahead
+    // of the game's by however long it has been since the game started
+    if (knife_enabled) {
+        knife_path.push_back({touchTime - t + this->t,
+                              Vector2(touchX, touchY), touchPressed});
+    } else {
+        knife_path.clear();
+    }
+
+    for (uint32_t step = 0; step < steps; step++) {
+        size_t before = entities.size();
+
+        // Spawn spawn_rate objects per second on average, which is a 1.5%
+        // chance every physics update in a normal game (which keeps it in real
+        // time). Rates of more than one object per update spawn the whole part
+        // every update and the fractional part by chance.
+        float expected = spawn_rate * dt;
+        int count = (int)expected;
+        if (rand_range(0, 1) <= expected - count)
+            count++;
+        if (exploding || ending)
+            count = 0;
+        for (int i = 0; i < count; i++)
+            spawn();
+
+        if (entities.size() > before && step > integrated) {
+            entities.physics_update(dt, step - integrated, 0, before);
+            integrated = step;
+        }
+
+        // shards of anything cut are launched from the end of the step, so
+        // everything else is caught up to there first
+        size_t uncut = entities.size();
+        if (!exploding && !ending)
+            cut_with_knife(this->t, this->t + dt);
+        if (entities.size() > uncut) {
+            entities.physics_update(dt, step + 1 - integrated, 0, uncut);
+            integrated = step + 1;
+        }
+
+        // Bounced objects carry on from the end of the step, so everything
+        // is caught up to there before they are sent off. Lost objects are
+        // retired first, since a bounce could otherwise bring one back.
+        if (config.object_collisions) {
+            retire_lost(this->t + dt);
+            if (collide_objects(this->t + dt, dt)) {
+                entities.physics_update(dt, step + 1 - integrated, 0,
+                                        entities.size());
+                integrated = step + 1;
+                for (uint32_t i : bounces) {
+                    entities.redirect(i, this->t + dt, dt,
+                                      Vector2(body_x[i], body_y[i]),
+                                      Vector2(body_vx[i], body_vy[i]));
+                }
             }
         }
+
+        this->t += dt;
     }
+    entities.physics_update(dt, steps - integrated);
+    if (!config.object_collisions)
+        retire_lost(this->t);
+    particles.physics_update(dt, steps);
 
-    physics_update_foreach(t, dt, apples);
-    physics_update_foreach(t, dt, bananas);
-    physics_update_foreach(t, dt, oranges);
-    physics_update_foreach(t, dt, cherries);
-    physics_update_foreach(t, dt, strawberries);
-    physics_update_foreach(t, dt, pineapples);
-    physics_update_foreach(t, dt, bombs);
-    physics_update_foreach(t, dt, fruit_shards);
-    
-    this->t += dt;
+    // everything up to the last sample the steps have reached has been cut
+    // along, and that sample is where the next cut starts from
+    size_t passed = 0;
+    while (passed + 1 < knife_path.size() &&
+           knife_path[passed + 1].t <= this->t)
+        passed++;
+    knife_path.erase(knife_path.begin(), knife_path.begin() + passed);
 }
 
 /// @author John Ulm
 void Game::update(double alpha) {
     // render background
-    background->render(LCD_WIDTH / 2, LCD_HEIGHT / 2, 0);
+    framebuffer->draw_background(*background);
 
     // display score
     const uint32_t CORNER_OFFSET = 15;
     auto num = std::to_string(points);
-    LCD.SetFontColor(WHITE);
-    LCD.WriteAt(num.c_str(), CORNER_OFFSET,
-                LCD_HEIGHT - FONT_GLYPH_HEIGHT - CORNER_OFFSET);
+    framebuffer->set_color(WHITE);
+    framebuffer->write_at(num, CORNER_OFFSET,
+                          LCD_HEIGHT - FONT_GLYPH_HEIGHT - CORNER_OFFSET);
 
     // display time
-    auto time_left = (int)(GAME_DURATION + 1 - (TimeNow() - time_started));
-    if (time_left >= 10) {
-        LCD.WriteAt(time_left, CORNER_OFFSET, CORNER_OFFSET);
-    } else {
-        LCD.WriteAt(0, CORNER_OFFSET, CORNER_OFFSET);
-        LCD.WriteAt(time_left, CORNER_OFFSET + FONT_GLYPH_WIDTH, CORNER_OFFSET);
+    auto time_left = (int)(GAME_DURATION + 1 - t);
+    if (timed && time_left >= 10) {
+        framebuffer->write_at(time_left, CORNER_OFFSET, CORNER_OFFSET);
+    } else if (timed) {
+        framebuffer->write_at(0, CORNER_OFFSET, CORNER_OFFSET);
+        framebuffer->write_at(time_left, CORNER_OFFSET + FONT_GLYPH_WIDTH,
+                              CORNER_OFFSET);
     }
 
     // display combo and combo time
     const float COMBO_DUR = 2.0;
-    if (TimeNow() - combo_time > COMBO_DUR) {
+    if (t - combo_time > COMBO_DUR) {
         combo = 0;
     }
 
@@ -190,58 +586,83 @@ void Game::update(double alpha) {
     unsigned int color2 = 0x214545 + game->combo * 0x050000;
 
     if (game->combo != 0) {
-        LCD.SetFontColor(std::min(color1, color2));
-        LCD.FillRectangle(
+        framebuffer->set_color(std::min(color1, color2));
+        framebuffer->fill_rectangle(
             LCD_WIDTH - (CORNER_OFFSET + 5 + 2 * FONT_GLYPH_WIDTH),
             CORNER_OFFSET - 5, 10 + 2 * FONT_GLYPH_WIDTH,
             10 + FONT_GLYPH_HEIGHT);
 
-        LCD.SetFontColor(0xffaaaaaa);
-        LCD.DrawRectangle(
+        framebuffer->set_color(0xffaaaaaa);
+        framebuffer->draw_rectangle(
             LCD_WIDTH - (CORNER_OFFSET + 5 + 2 * FONT_GLYPH_WIDTH),
             CORNER_OFFSET - 5, 10 + 2 * FONT_GLYPH_WIDTH,
             10 + FONT_GLYPH_HEIGHT);
 
-        LCD.SetFontColor(WHITE);
-        LCD.WriteAt((int)(game->combo),
-                    LCD_WIDTH - CORNER_OFFSET -
-                        FONT_GLYPH_WIDTH * (int)(log10(game->combo) + 1),
-                    CORNER_OFFSET);
-        LCD.DrawHorizontalLine(CORNER_OFFSET + FONT_GLYPH_HEIGHT + 2,
-                               LCD_WIDTH - CORNER_OFFSET,
-                               LCD_WIDTH - CORNER_OFFSET +
-                                   FONT_GLYPH_WIDTH * 2 / COMBO_DUR *
-                                       (TimeNow() - combo_time - COMBO_DUR));
+        framebuffer->set_color(WHITE);
+        framebuffer->write_at(
+            (int)(game->combo),
+            LCD_WIDTH - CORNER_OFFSET -
+                FONT_GLYPH_WIDTH * (int)(log10(game->combo) + 1),
+            CORNER_OFFSET);
+        framebuffer->draw_horizontal_line(
+            CORNER_OFFSET + FONT_GLYPH_HEIGHT + 2, LCD_WIDTH - CORNER_OFFSET,
+            LCD_WIDTH - CORNER_OFFSET +
+                FONT_GLYPH_WIDTH * 2 / COMBO_DUR *
+                    (t - combo_time - COMBO_DUR));
     }
 
     // remove physics objects if they've gone out of bounds or otherwise need to
     // be destroyed
-    remove_if_foreach(apples);
-    remove_if_foreach(bananas);
-    remove_if_foreach(oranges);
-    remove_if_foreach(cherries);
-    remove_if_foreach(strawberries);
-    remove_if_foreach(pineapples);
-    remove_if_foreach(bombs);
-    remove_if_foreach(fruit_shards);
-
-    // update physics objects
-    update_foreach(alpha, apples);
-    update_foreach(alpha, bananas);
-    update_foreach(alpha, oranges);
-    update_foreach(alpha, cherries);
-    update_foreach(alpha, strawberries);
-    update_foreach(alpha, pineapples);
-    update_foreach(alpha, bombs);
+    entities.remove_flagged();
 
-    // update and draw knife
-    knife.update();
+    // update and draw every fruit, bomb, and fruit shard
+    entities.interpolate(alpha, t - (1 - alpha) * last_dt);
+    for (size_t i = 0; i < entities.size(); i++) {
+        float x = entities.draw_x[i];
+        float y = entities.draw_y[i];
+        float radius = entities.radius[i];
+        float theta = spin(t, entities.draw_vx[i]);
+        const Image& image = image_repository->sprite(entities.sprite[i]);
+
+        // Skip anything entirely off screen before it is rotated or drawn.
+        // The box around the rotated sprite is never bigger than its reach,
+        // which is tighter for sprites with transparent corners.
+        float c = std::abs(std::cos(theta));
+        float s = std::abs(std::sin(theta));
+        float reach = image.reach();
+        float extent_x =
+            std::min(reach, (c * image.width() + s * image.height()) / 2);
+        float extent_y =
+            std::min(reach, (s * image.width() + c * image.height()) / 2);
+        if (entities.type[i] == EntityType::Bomb) {
+            extent_x = std::max(extent_x, radius + BOMB_RING);
+            extent_y = std::max(extent_y, radius + BOMB_RING);
+        }
+        extent_x += CULL_MARGIN;
+        extent_y += CULL_MARGIN;
+        if (x + extent_x < 0 || x - extent_x > LCD_WIDTH || y + extent_y < 0 ||
+            y - extent_y > LCD_HEIGHT)
+            continue;
 
-    // update and draw fruit shards
-    update_foreach(alpha, fruit_shards);
+        image_repository->rotated(image, theta).render(x, y, 0);
+
+        if (entities.type[i] == EntityType::Bomb) {
+            framebuffer->set_color(RED);
+            draw_circle(x, y, radius + BOMB_RING);
+        }
+    }
+
+    particles.render();
+    profiler->count_particles(particles.size());
+
+    // update and draw knife
+    if (knife_enabled)
+        knife.update();
 
-    // End the game if the game has gone on for max duration
-    if (GAME_DURATION <= TimeNow() - time_started) {
+    // End the game if the game has gone on for max duration, or a bomb's
+    // explosion has finished
+    if (!ending &&
+        ((timed && GAME_DURATION <= t) || (exploding && explosion_end <= t))) {
         end();
     }
 }
\ No newline at end of file
@@ -7,9 +7,12 @@
 #include <memory>
 #include <vector>
 
+#include "entities.h"
+#include "grid.h"
 #include "image.h"
 #include "knife.h"
-#include "throwable.h"
+#include "particles.h"
+#include "sweep.h"
 #include "util.h"
 
 /// Main Scene for playing the game
@@ -28,25 +31,37 @@ class Game final : public Scene {
     /// @param dt physics timestep
     void physics_update(double t, double dt);
 
+    /// Run several physics updates back to back, integrating every object
+    /// through all of them in as few passes as possible, and cut along where
+    /// the knife went during each of them
+    /// @param t time since start of game
+    /// @param dt physics timestep
+    /// @param steps number of physics updates to run
+    void physics_steps(double t, double dt, uint32_t steps);
+
     /// Start a new game
     /// @param bomb_probability probability [0, 1] that any given thrown object
     /// will be a bomb
     /// @param multiplier score multiplier (rewarding higher difficulties)
     void start(float bomb_probability, float multiplier);
 
-    /// End the current game
+    /// End the current game, wiping the screen over the next few frames
+    /// before showing the end screen
     void end();
 
-    /// Check if the line segment formed by p1 and p2 intersects with any fruits
-    /// or bombs, and handles collision and effects accordingly
-    /// @param p1 Screenspace coordinate vector for the first endpoint of the
-    /// line segment
-    /// @param p2 Screenspace coordinate vector for the last endpoint of the
-    /// line segment
-    void collide_with_knife(Vector2 p1, Vector2 p2);
+    /// Throw a random fruit, or a bomb with the current bomb probability, from
+    /// below the screen
+    void spawn();
+
+    /// Number of fruits, bombs, and fruit shards currently alive
+    size_t object_count() const;
 
-    /// All fruit shards which need to be updated and rendered
-    std::vector<std::unique_ptr<FruitShard>> fruit_shards;
+    /// Every fruit, bomb, and fruit shard which needs to be updated and
+    /// rendered
+    Entities entities;
+
+    /// Explosions, juice, and sparks
+    Particles particles;
 
     /// Number of points scored in the game
     uint32_t points;
@@ -54,34 +69,121 @@ class Game final : public Scene {
     /// Current combo in the game
     uint32_t combo;
 
-    /// Time that the most recent fruit was cut
+    /// Game time that the most recent fruit was cut
     double combo_time;
 
     /// Score multiplier (should reward higher difficulties)
     float multiplier;
- 
+
     /// Physics time elapsed since start of the game
     double t;
 
+    /// Length of the most recent physics step
+    double last_dt;
+
+    /// Average number of objects thrown per second. Set by start, and may be
+    /// changed while the game is running.
+    float spawn_rate;
+
+    /// Whether the game ends after GAME_DURATION seconds. Set by start.
+    bool timed;
+
+    /// Whether touches slice with the knife. Set by start.
+    bool knife_enabled;
+
    private:
     /// Duration of the game in seconds
     const uint32_t GAME_DURATION = 30;
+    /// Seconds a bomb's explosion plays for before the game ends
+    const float EXPLOSION_DURATION = 0.85;
+    /// Average number of objects thrown per second in a normal game
+    const float SPAWN_RATE = 1.5;
     /// value that determines rate that bombs spawn
     float bomb_probability;
-    /// start time
-    double time_started;
+    /// Whether a bomb has gone off, which ends the game once its explosion
+    /// has played
+    bool exploding;
+    /// Physics time the explosion finishes playing
+    double explosion_end;
+    /// Whether the game has ended and the screen is being wiped
+    bool ending;
+
+    friend struct SliceInHalf;
+    friend struct Explode;
+
+    /// Where the knife was at some physics time
+    struct KnifeSample {
+        double t;
+        Vector2 position;
+        bool pressed;
+    };
+
+    /// Cut every fruit and bomb the knife passed through during a physics
+    /// step, with both moving in a straight line from where they were at the
+    /// start of it to where they were at the end, and handle the effects.
+    /// Cutting stops at the first bomb.
+    /// @param t1 physics time at the start of the step
+    /// @param t2 physics time at the end of the step
+    void cut_with_knife(double t1, double t2);
+
+    /// Remove every object whose parabola can never bring it back on screen,
+    /// once it is past the bottom and falling or past a side and moving away
+    /// from it. Only its own parabola is considered, so with objects
+    /// colliding this has to run before they collide, so that nothing can
+    /// bounce a lost object back.
+    /// @param t physics time to check at
+    void retire_lost(double t);
+
+    /// Find the fruits and bombs overlapping each other at the end of a
+    /// physics step, and work out where they move to and how fast so that
+    /// they bounce apart, without changing them yet
+    /// @param t physics time at the end of the step
+    /// @param dt physics timestep
+    /// @return whether anything bounced
+    bool collide_objects(double t, double dt);
+
+    /// Cut a fruit in half, replacing it with two shards launched at the end
+    /// of the current physics step, splash its juice, and score it
+    /// @param i index of the fruit entity
+    /// @param left sprite of the left half
+    /// @param right sprite of the right half
+    /// @param juice color of its juice as 0xRRGGBB
+    void slice(size_t i, SpriteId left, SpriteId right, uint32_t juice);
+
+    /// Blow up a bomb, which ends the game once the explosion has played
+    /// @param bomb index of the bomb entity
+    void explode(size_t bomb);
 
     Knife knife;
 
-    std::shared_ptr<Image> background;
+    /// Where the knife has been since the last physics step that has not been
+    /// cut along yet, and the sample before, in order of time
+    std::vector<KnifeSample> knife_path;
+    /// Indices of the fruits and bombs, and where they are at the start and
+    /// end of the physics step being cut, kept to avoid allocating every step
+    std::vector<uint32_t> swept;
+    std::vector<float> swept_x1, swept_y1, swept_x2, swept_y2, swept_radius;
+    /// Fruits and bombs by the path they take over the step, for finding the
+    /// ones the knife passes near
+    SpatialGrid grid;
+    /// Indices into swept, positions, and radii of the fruits and bombs near
+    /// the knife for part of a step, and which of them it hit
+    std::vector<uint32_t> near_knife;
+    std::vector<float> near_x1, near_y1, near_x2, near_y2, near_radius;
+    std::vector<uint64_t> near_hits;
+
+    /// Fruits and bombs sorted along the x axis, for finding the ones touching
+    SweepAndPrune sweep;
+    /// Pairs of fruits and bombs whose boxes overlap
+    std::vector<EntityPair> touching;
+    /// Where every entity is at the end of the step being collided, and how
+    /// fast the ones that bounced are going, by index
+    std::vector<float> body_x, body_y, body_vx, body_vy;
+    /// Whether each entity has bounced, and the ones that have
+    std::vector<uint8_t> bounced;
+    std::vector<uint32_t> bounces;
 
-    std::vector<std::unique_ptr<Apple>> apples;
-    std::vector<std::unique_ptr<Bananas>> bananas;
-    std::vector<std::unique_ptr<Orange>> oranges;
-    std::vector<std::unique_ptr<Cherries>> cherries;
-    std::vector<std::unique_ptr<Strawberry>> strawberries;
-    std::vector<std::unique_ptr<Pineapple>> pineapples;
-    std::vector<std::unique_ptr<Bomb>> bombs;
+    std::shared_ptr<Image> background;
 };
 
 /// Global variable to hold the state of the game
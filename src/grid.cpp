@@ -0,0 +1,139 @@
+/// @file grid.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of the uniform grid
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include "grid.h"
+#include "ui.h"
+
+/// Pixels added around every bounding box, so that rounding in the walk along
+/// a segment can never step past a cell holding a circle it touches
+static const float MARGIN = 1;
+
+bool SpatialGrid::cells(float x0,
+                        float y0,
+                        float x1,
+                        float y1,
+                        CellRange& range) const {
+    range.x0 = (int)std::floor((x0 - MARGIN) / cell_size);
+    range.y0 = (int)std::floor((y0 - MARGIN) / cell_size);
+    range.x1 = (int)std::floor((x1 + MARGIN) / cell_size);
+    range.y1 = (int)std::floor((y1 + MARGIN) / cell_size);
+    if (range.x1 < 0 || range.y1 < 0 || range.x0 >= columns ||
+        range.y0 >= rows)
+        return false;
+
+    range.x0 = std::max(range.x0, 0);
+    range.y0 = std::max(range.y0, 0);
+    range.x1 = std::min(range.x1, columns - 1);
+    range.y1 = std::min(range.y1, rows - 1);
+    return true;
+}
+
+void SpatialGrid::build(const float* x1,
+                        const float* y1,
+                        const float* x2,
+                        const float* y2,
+                        const float* r,
+                        size_t n,
+                        int cell_size) {
+    this->cell_size = std::max(cell_size, 1);
+    columns = ((int)LCD_WIDTH + this->cell_size - 1) / this->cell_size;
+    rows = ((int)LCD_HEIGHT + this->cell_size - 1) / this->cell_size;
+    size_t cell_count = (size_t)columns * rows;
+
+    // counting sort of circles into cells: count each cell's circles, turn the
+    // counts into where each cell starts, then fill the cells in. A circle
+    // off the grid gets an empty range so the second pass skips it too.
+    cell_start.assign(cell_count + 1, 0);
+    ranges.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        CellRange& range = ranges[i];
+        if (!cells(std::min(x1[i], x2[i]) - r[i], std::min(y1[i], y2[i]) - r[i],
+                   std::max(x1[i], x2[i]) + r[i], std::max(y1[i], y2[i]) + r[i],
+                   range)) {
+            range = {0, 0, -1, -1};
+            continue;
+        }
+
+        for (int cy = range.y0; cy <= range.y1; cy++)
+            for (int cx = range.x0; cx <= range.x1; cx++)
+                cell_start[(size_t)cy * columns + cx + 1]++;
+    }
+
+    for (size_t c = 0; c < cell_count; c++)
+        cell_start[c + 1] += cell_start[c];
+
+    cursor.assign(cell_start.begin(), cell_start.end() - 1);
+    cell_circles.resize(cell_start[cell_count]);
+    for (size_t i = 0; i < n; i++) {
+        const CellRange& range = ranges[i];
+        for (int cy = range.y0; cy <= range.y1; cy++)
+            for (int cx = range.x0; cx <= range.x1; cx++)
+                cell_circles[cursor[(size_t)cy * columns + cx]++] = i;
+    }
+
+    seen.assign(n, 0);
+    stamp = 0;
+}
+
+void SpatialGrid::query(Vector2 p1, Vector2 p2, std::vector<uint32_t>& found) {
+    found.clear();
+    if (++stamp == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        stamp = 1;
+    }
+
+    // Build puts circles hanging off the grid into the cells on its edge, so
+    // a cell off the grid is looked up in the nearest one on the edge. That
+    // also covers a knife on the right or bottom edge of the screen, which is
+    // just past the last cell.
+    auto visit = [&](int cx, int cy) {
+        cx = std::clamp(cx, 0, columns - 1);
+        cy = std::clamp(cy, 0, rows - 1);
+
+        size_t c = (size_t)cy * columns + cx;
+        for (uint32_t k = cell_start[c]; k < cell_start[c + 1]; k++) {
+            uint32_t i = cell_circles[k];
+            if (seen[i] != stamp) {
+                seen[i] = stamp;
+                found.push_back(i);
+            }
+        }
+    };
+
+    // walk the cells along the segment one boundary crossing at a time
+    // http://www.cse.yorku.ca/~amana/research/grid.pdf
+    float x = p1.x / cell_size, y = p1.y / cell_size;
+    float dx = p2.x / cell_size - x, dy = p2.y / cell_size - y;
+    int cx = (int)std::floor(x), cy = (int)std::floor(y);
+    int end_x = (int)std::floor(p2.x / cell_size);
+    int end_y = (int)std::floor(p2.y / cell_size);
+
+    const float NEVER = std::numeric_limits<float>::infinity();
+    int step_x = dx > 0 ? 1 : -1;
+    int step_y = dy > 0 ? 1 : -1;
+    float next_x = dx > 0 ? (cx + 1 - x) / dx : dx < 0 ? (x - cx) / -dx : NEVER;
+    float next_y = dy > 0 ? (cy + 1 - y) / dy : dy < 0 ? (y - cy) / -dy : NEVER;
+    float delta_x = dx != 0 ? 1 / std::abs(dx) : NEVER;
+    float delta_y = dy != 0 ? 1 / std::abs(dy) : NEVER;
+
+    visit(cx, cy);
+    int crossings = std::abs(end_x - cx) + std::abs(end_y - cy);
+    for (int n = 0; n < crossings; n++) {
+        if (next_x < next_y) {
+            cx += step_x;
+            next_x += delta_x;
+        } else {
+            cy += step_y;
+            next_y += delta_y;
+        }
+        visit(cx, cy);
+    }
+
+    std::sort(found.begin(), found.end());
+}
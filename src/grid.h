@@ -0,0 +1,76 @@
+#pragma once
+
+/// @file grid.h
+/// @author Mark Bundschuh
+/// @brief Uniform grid for finding the entities near the knife
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "util.h"
+
+/// Uniform grid over the screen, holding every circle in each cell the
+/// bounding box of its path over a physics step overlaps, so that a line
+/// segment only needs to be tested against the circles in the cells it passes
+/// through
+class SpatialGrid {
+   public:
+    /// Throw out the grid's contents and index circles moving from one place to
+    /// another. Anything entirely off screen is left out.
+    /// @param x1 x coordinates of where the centers of the circles start
+    /// @param y1 y coordinates of where the centers of the circles start
+    /// @param x2 x coordinates of where the centers of the circles end
+    /// @param y2 y coordinates of where the centers of the circles end
+    /// @param r radii of the circles
+    /// @param n number of circles
+    /// @param cell_size width and height of each cell in pixels
+    void build(const float* x1,
+               const float* y1,
+               const float* x2,
+               const float* y2,
+               const float* r,
+               size_t n,
+               int cell_size);
+
+    /// Find every circle in the cells a line segment passes through, where
+    /// the parts of it off the grid are in the nearest cells on its edge
+    /// @param p1 first endpoint of the line segment
+    /// @param p2 last endpoint of the line segment
+    /// @param found set to the indices of the circles, each once and in
+    /// increasing order
+    void query(Vector2 p1, Vector2 p2, std::vector<uint32_t>& found);
+
+   private:
+    /// Range of cells a bounding box overlaps
+    struct CellRange {
+        int x0, y0, x1, y1;
+    };
+
+    /// Cells a bounding box overlaps, clamped to the grid
+    /// @param x0 left edge of the box
+    /// @param y0 top edge of the box
+    /// @param x1 right edge of the box
+    /// @param y1 bottom edge of the box
+    /// @param range set to the cells
+    /// @return whether the box is on the grid at all
+    bool cells(float x0, float y0, float x1, float y1, CellRange& range) const;
+
+    int cell_size = 1;
+    int columns = 0;
+    int rows = 0;
+
+    /// Where each cell's circles start in cell_circles, with one extra at the
+    /// end, so cell c holds cell_circles[cell_start[c], cell_start[c+1])
+    std::vector<uint32_t> cell_start;
+    std::vector<uint32_t> cell_circles;
+    /// Cells each circle overlaps, worked out once while building
+    std::vector<CellRange> ranges;
+    /// Next place to write in each cell while building
+    std::vector<uint32_t> cursor;
+
+    /// Query each circle was last found by, so each is only found once
+    std::vector<uint32_t> seen;
+    /// Number of the current query
+    uint32_t stamp = 0;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+/// @file FEHLCD.h
+/// @author Mark Bundschuh
+/// @brief Headless stand-in for the subset of the FEH Proteus LCD that the game
+/// uses, drawing into memory instead of a window
+
+#include <cstdint>
+
+#define BLACK 0x000000u
+#define WHITE 0xFFFFFFu
+#define RED 0xFF0000u
+#define INDIANRED 0xCD5C5Cu
+#define DARKGOLDENROD 0xB8860Bu
+#define GRAY 0x808080u
+#define FIREBRICK 0xB22222u
+
+/// In-memory LCD. Touch input comes from a script instead of a mouse. The
+/// backend is configured with environment variables:
+///  - HEADLESS_TOUCH: path to a touch script, where each line is either
+///    "<seconds> <x> <y>" to touch at a point or "<seconds> up" to let go
+///  - HEADLESS_FRAME_TIME: if set, time is simulated and every call to Touch
+///    (once per frame) advances it by this many seconds, and Sleep returns
+///    immediately
+///  - HEADLESS_FRAMES: exit after this many frames
+///  - HEADLESS_DUMP: path to write the final screen to as a binary PPM image
+class FEHLCD {
+   public:
+    /// Width in pixels of the screen
+    static const int WIDTH = 320;
+    /// Height in pixels of the screen
+    static const int HEIGHT = 240;
+
+    /// Default constructor
+    FEHLCD();
+
+    /// Retrieve the scripted touch state at the current time
+    /// @param x_pos set to the touched x coordinate, if touched
+    /// @param y_pos set to the touched y coordinate, if touched
+    /// @return whether the screen is being touched
+    int Touch(int* x_pos, int* y_pos);
+    int Touch(float* x_pos, float* y_pos);
+
+    void Clear();
+    void Clear(unsigned int color);
+    void SetFontColor(unsigned int color);
+    void SetBackgroundColor(unsigned int color);
+
+    void DrawPixel(int x, int y);
+    void DrawHorizontalLine(int y, int x1, int x2);
+    void DrawVerticalLine(int x, int y1, int y2);
+    void DrawRectangle(int x, int y, int width, int height);
+    void FillRectangle(int x, int y, int width, int height);
+
+    /// Write text. There is no font, so every visible character is drawn as
+    /// a solid block inside its 12 by 15 pixel cell.
+    void WriteAt(const char* text, int x, int y);
+    void WriteAt(int value, int x, int y);
+    void WriteAt(float value, int x, int y);
+    void WriteAt(double value, int x, int y);
+
+    /// Finish a frame
+    void Update();
+
+    /// Retrieve the screen contents
+    /// @return WIDTH * HEIGHT row-major 0xRRGGBB pixels
+    const uint32_t* Pixels() const;
+
+   private:
+    uint32_t pixels[WIDTH * HEIGHT];
+    uint32_t font_color;
+    uint32_t background_color;
+};
+
+/// Global variable holding the LCD, the same as the simulator
+extern FEHLCD LCD;
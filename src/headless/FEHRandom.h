@@ -0,0 +1,15 @@
+#pragma once
+
+/// @file FEHRandom.h
+/// @author Mark Bundschuh
+/// @brief Headless stand-in for the FEH Proteus random number generator
+
+/// Random number generator
+class FEHRandom {
+   public:
+    /// Retrieve a random number in [0, 32767]
+    int RandInt();
+};
+
+/// Global variable holding the random number generator
+extern FEHRandom Random;
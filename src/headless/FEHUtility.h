@@ -0,0 +1,18 @@
+#pragma once
+
+/// @file FEHUtility.h
+/// @author Mark Bundschuh
+/// @brief Headless stand-in for the FEH Proteus time utilities
+
+/// Sleep for a number of milliseconds
+void Sleep(int msec);
+/// Sleep for a number of seconds
+void Sleep(float sec);
+/// Sleep for a number of seconds
+void Sleep(double sec);
+
+/// Seconds since the program started (or since ResetTime)
+double TimeNow();
+
+/// Restart the clock from zero
+void ResetTime();
@@ -0,0 +1,288 @@
+/// @file headless.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of the headless LCD, time and random backend
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FEHLCD.h"
+#include "FEHRandom.h"
+#include "FEHUtility.h"
+
+/// Width in pixels of a character cell
+const int GLYPH_WIDTH = 12;
+/// Height in pixels of a character cell
+const int GLYPH_HEIGHT = 15;
+
+/// A scripted change in touch state
+struct TouchEvent {
+    double time;
+    bool pressed;
+    int x, y;
+};
+
+/// Settings read from the environment and state shared by the backend
+struct Headless {
+    Headless();
+
+    /// Seconds every frame advances simulated time by, or 0 for real time
+    double frame_time = 0;
+    /// Number of frames to run before exiting, or 0 to run forever
+    unsigned long max_frames = 0;
+    /// Path to dump the final screen to, straight from the environment since
+    /// headless itself is destroyed before the dump runs at exit
+    const char* dump_path = nullptr;
+
+    std::vector<TouchEvent> touches;
+    size_t next_touch = 0;
+    TouchEvent touch = {0, false, 0, 0};
+
+    unsigned long frames = 0;
+    double simulated_time = 0;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point wall_start;
+};
+
+/// Read a touch script
+/// @param path path to the script
+/// @return events in the script, sorted by time
+static std::vector<TouchEvent> read_touch_script(const char* path) {
+    std::vector<TouchEvent> events;
+    std::ifstream file(path);
+    if (!file)
+        std::cerr << "headless: could not open touch script " << path
+                  << std::endl;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream fields(line);
+        TouchEvent event = {0, true, 0, 0};
+        std::string x;
+        if (!(fields >> event.time >> x))
+            continue;
+
+        if (x == "up") {
+            event.pressed = false;
+        } else {
+            event.x = std::atoi(x.c_str());
+            fields >> event.y;
+        }
+
+        events.push_back(event);
+    }
+
+    std::stable_sort(
+        events.begin(), events.end(),
+        [](const TouchEvent& a, const TouchEvent& b) { return a.time < b.time; });
+    return events;
+}
+
+/// Write the screen as a binary PPM image
+static void dump_screen();
+
+Headless::Headless()
+    : start(std::chrono::steady_clock::now()), wall_start(start) {
+    if (const char* value = std::getenv("HEADLESS_FRAME_TIME"))
+        frame_time = std::atof(value);
+    if (const char* value = std::getenv("HEADLESS_FRAMES"))
+        max_frames = std::strtoul(value, nullptr, 10);
+    if (const char* value = std::getenv("HEADLESS_DUMP"))
+        dump_path = value;
+    if (const char* value = std::getenv("HEADLESS_TOUCH"))
+        touches = read_touch_script(value);
+
+    std::atexit(dump_screen);
+}
+
+/// Global variable holding the backend settings and state
+Headless headless;
+
+FEHLCD LCD;
+FEHRandom Random;
+
+static void dump_screen() {
+    if (!headless.dump_path)
+        return;
+
+    std::ofstream file(headless.dump_path, std::ios::binary);
+    file << "P6\n" << FEHLCD::WIDTH << " " << FEHLCD::HEIGHT << "\n255\n";
+    const uint32_t* pixels = LCD.Pixels();
+    for (int i = 0; i < FEHLCD::WIDTH * FEHLCD::HEIGHT; i++) {
+        char rgb[3] = {(char)(pixels[i] >> 16), (char)(pixels[i] >> 8),
+                       (char)pixels[i]};
+        file.write(rgb, 3);
+    }
+}
+
+double TimeNow() {
+    if (headless.frame_time > 0)
+        return headless.simulated_time;
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         headless.start)
+        .count();
+}
+
+void ResetTime() {
+    headless.simulated_time = 0;
+    headless.start = std::chrono::steady_clock::now();
+}
+
+void Sleep(double sec) {
+    if (sec <= 0)
+        return;
+
+    if (headless.frame_time > 0)
+        headless.simulated_time += sec;
+    else
+        std::this_thread::sleep_for(std::chrono::duration<double>(sec));
+}
+
+void Sleep(float sec) {
+    Sleep((double)sec);
+}
+
+void Sleep(int msec) {
+    Sleep(msec / 1000.0);
+}
+
+int FEHRandom::RandInt() {
+    return std::rand() & 0x7fff;
+}
+
+FEHLCD::FEHLCD() : font_color(WHITE), background_color(BLACK) {
+    Clear();
+}
+
+int FEHLCD::Touch(int* x_pos, int* y_pos) {
+    // a frame is one poll for input
+    if (headless.max_frames != 0 && headless.frames >= headless.max_frames) {
+        double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() -
+                             headless.wall_start)
+                             .count();
+        std::fprintf(stderr, "headless: %lu frames in %.3f s (%.1f fps)\n",
+                     headless.frames, seconds, headless.frames / seconds);
+        std::exit(0);
+    }
+
+    headless.frames++;
+    if (headless.frame_time > 0)
+        headless.simulated_time += headless.frame_time;
+
+    double now = TimeNow();
+    while (headless.next_touch < headless.touches.size() &&
+           headless.touches[headless.next_touch].time <= now)
+        headless.touch = headless.touches[headless.next_touch++];
+
+    if (headless.touch.pressed) {
+        *x_pos = headless.touch.x;
+        *y_pos = headless.touch.y;
+    }
+
+    return headless.touch.pressed;
+}
+
+int FEHLCD::Touch(float* x_pos, float* y_pos) {
+    int x = 0, y = 0;
+    int pressed = Touch(&x, &y);
+    if (pressed) {
+        *x_pos = x;
+        *y_pos = y;
+    }
+    return pressed;
+}
+
+void FEHLCD::Clear() {
+    Clear(background_color);
+}
+
+void FEHLCD::Clear(unsigned int color) {
+    std::fill(pixels, pixels + WIDTH * HEIGHT, color & 0xffffff);
+}
+
+void FEHLCD::SetFontColor(unsigned int color) {
+    font_color = color & 0xffffff;
+}
+
+void FEHLCD::SetBackgroundColor(unsigned int color) {
+    background_color = color & 0xffffff;
+}
+
+void FEHLCD::DrawPixel(int x, int y) {
+    if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT)
+        pixels[y * WIDTH + x] = font_color;
+}
+
+void FEHLCD::DrawHorizontalLine(int y, int x1, int x2) {
+    if (x2 < x1)
+        std::swap(x1, x2);
+    if (y < 0 || y >= HEIGHT)
+        return;
+
+    x1 = std::max(x1, 0);
+    x2 = std::min(x2, WIDTH - 1);
+    for (int x = x1; x <= x2; x++)
+        pixels[y * WIDTH + x] = font_color;
+}
+
+void FEHLCD::DrawVerticalLine(int x, int y1, int y2) {
+    if (y2 < y1)
+        std::swap(y1, y2);
+    for (int y = y1; y <= y2; y++)
+        DrawPixel(x, y);
+}
+
+void FEHLCD::DrawRectangle(int x, int y, int width, int height) {
+    DrawHorizontalLine(y, x, x + width);
+    DrawHorizontalLine(y + height, x, x + width);
+    DrawVerticalLine(x, y, y + height);
+    DrawVerticalLine(x + width, y, y + height);
+}
+
+void FEHLCD::FillRectangle(int x, int y, int width, int height) {
+    for (int j = y; j < y + height; j++)
+        DrawHorizontalLine(j, x, x + width - 1);
+}
+
+void FEHLCD::WriteAt(const char* text, int x, int y) {
+    for (; *text != '\0'; text++, x += GLYPH_WIDTH) {
+        if (*text == ' ')
+            continue;
+
+        for (int j = 2; j < GLYPH_HEIGHT - 2; j++)
+            DrawHorizontalLine(y + j, x + 2, x + GLYPH_WIDTH - 3);
+    }
+}
+
+void FEHLCD::WriteAt(int value, int x, int y) {
+    WriteAt(std::to_string(value).c_str(), x, y);
+}
+
+void FEHLCD::WriteAt(float value, int x, int y) {
+    WriteAt((double)value, x, y);
+}
+
+void FEHLCD::WriteAt(double value, int x, int y) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f", value);
+    WriteAt(text, x, y);
+}
+
+void FEHLCD::Update() {}
+
+const uint32_t* FEHLCD::Pixels() const {
+    return pixels;
+}
@@ -5,163 +5,328 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <memory>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-#include "FEHLCD.h"
-
+#include "config.h"
+#include "framebuffer.h"
 #include "image.h"
 #include "ui.h"
 #include "util.h"
 
-Image::Image(std::string filename) {
+#define PI 3.14159265358979323846
+
+Image::Image(std::string filename) : w(0), h(0), channelCount(0) {
     stbi_uc* image = stbi_load(filename.c_str(), &w, &h, &channelCount, 4);
+    load(image);
+}
 
-    colors = std::make_unique<std::vector<std::vector<uint32_t>>>(
-        w, std::vector<uint32_t>(h));
-
-    for (int i = 0; i < w; i++) {
-        for (int j = 0; j < h; j++) {
-            uint32_t bytePerPixel = channelCount;
-            uint8_t* pixelOffset = image + (i + w * j) * bytePerPixel;
-            uint8_t r = pixelOffset[0];
-            uint8_t g = pixelOffset[1];
-            uint8_t b = pixelOffset[2];
-            uint8_t a = channelCount >= 4 ? pixelOffset[3] : 0xff;
-            colors->at(i)[j] = (a << 24) + (r << 16) + (g << 8) + (b << 0);
-        }
+Image::Image(const unsigned char* data, size_t data_len)
+    : w(0), h(0), channelCount(0) {
+    stbi_uc* image =
+        stbi_load_from_memory(data, data_len, &w, &h, &channelCount, 4);
+    load(image);
+}
+
+Image::Image(int width, int height, PixelBuffer pixels)
+    : w(width), h(height), channelCount(4), pixels(std::move(pixels)) {
+    opaque = std::all_of(this->pixels.begin(), this->pixels.end(),
+                         [](uint32_t color) { return (color >> 24) == 0xff; });
+    build_mask();
+}
+
+void Image::load(const unsigned char* image) {
+    if (image == nullptr) {
+        std::cerr << "failed to load image: " << stbi_failure_reason()
+                  << std::endl;
+        w = h = 0;
+        opaque = true;
+        build_mask();
+        return;
     }
 
-    stbi_image_free(image);
+    // stb_image lays its output out row-major with 4 bytes per pixel (we
+    // always request 4 components, regardless of channelCount), which is
+    // exactly the order of our pixel buffer, so a single sequential pass
+    // suffices
+    pixels.resize((size_t)w * h);
+    opaque = true;
+    const uint8_t* pixel = image;
+    for (uint32_t& color : pixels) {
+        uint32_t r = pixel[0];
+        uint32_t g = pixel[1];
+        uint32_t b = pixel[2];
+        uint32_t a = pixel[3];
+        color = (a << 24) | (r << 16) | (g << 8) | (b << 0);
+        opaque &= a == 0xff;
+        pixel += 4;
+    }
+
+    stbi_image_free((void*)image);
+    build_mask();
 }
 
-Image::Image(const unsigned char* data, size_t data_len) {
-    stbi_uc* image =
-        stbi_load_from_memory(data, data_len, &w, &h, &channelCount, 4);
+void Image::build_mask() {
+    mask_stride = (w + 63) / 64;
+    mask.assign((size_t)mask_stride * h, 0);
+    spans.assign(h, {0, 0});
+
+    float center_x = w / 2.0f;
+    float center_y = h / 2.0f;
+    float reach_squared = 0;
+    for (int j = 0; j < h; j++) {
+        const uint32_t* pixel = row(j);
+        uint64_t* bits = mask.data() + (size_t)j * mask_stride;
+        RowSpan& span = spans[j];
+        for (int i = 0; i < w; i++) {
+            if ((pixel[i] >> 24) < OPAQUE_ALPHA)
+                continue;
+
+            bits[i / 64] |= (uint64_t)1 << (i % 64);
+            if (span.begin == span.end)
+                span.begin = i;
+            span.end = i + 1;
 
-    colors = std::make_unique<std::vector<std::vector<uint32_t>>>(
-        w, std::vector<uint32_t>(h));
-
-    for (int i = 0; i < w; i++) {
-        for (int j = 0; j < h; j++) {
-            uint32_t bytePerPixel = channelCount;
-            uint8_t* pixelOffset = image + (i + w * j) * bytePerPixel;
-            uint8_t r = pixelOffset[0];
-            uint8_t g = pixelOffset[1];
-            uint8_t b = pixelOffset[2];
-            uint8_t a = channelCount >= 4 ? pixelOffset[3] : 0xff;
-            colors->at(i)[j] = (a << 24) + (r << 16) + (g << 8) + (b << 0);
+            // the corner of the pixel furthest from the center
+            float dx = std::max(std::abs(i - center_x),
+                                std::abs(i + 1 - center_x));
+            float dy = std::max(std::abs(j - center_y),
+                                std::abs(j + 1 - center_y));
+            reach_squared = std::max(reach_squared, dx * dx + dy * dy);
         }
     }
+    reach_radius = std::sqrt(reach_squared);
+}
 
-    stbi_image_free(image);
+bool Image::segment_hits(Vector2 p1, Vector2 p2, float theta) const {
+    // into image space, with the same inverse mapping render uses
+    float c = std::cos(theta);
+    float s = std::sin(theta);
+    float u1 = w / 2.0f + c * p1.x + s * p1.y;
+    float v1 = h / 2.0f - s * p1.x + c * p1.y;
+    float u2 = w / 2.0f + c * p2.x + s * p2.y;
+    float v2 = h / 2.0f - s * p2.x + c * p2.y;
+
+    // one row at a time, take the columns the segment covers while inside the
+    // row, trim them to the opaque part of the row, then check the pixels
+    // there a word at a time
+    float v_min = std::min(v1, v2);
+    float v_max = std::max(v1, v2);
+    int j0 = std::max((int)std::floor(v_min), 0);
+    int j1 = std::min((int)std::floor(v_max), h - 1);
+    float slope = v1 != v2 ? (u2 - u1) / (v2 - v1) : 0;
+    for (int j = j0; j <= j1; j++) {
+        float ua, ub;
+        if (v1 == v2) {
+            ua = u1;
+            ub = u2;
+        } else {
+            ua = u1 + (std::max((float)j, v_min) - v1) * slope;
+            ub = u1 + (std::min((float)j + 1, v_max) - v1) * slope;
+        }
+
+        const RowSpan& span = spans[j];
+        int i0 = std::max((int)std::floor(std::min(ua, ub)), span.begin);
+        int i1 = std::min((int)std::floor(std::max(ua, ub)), span.end - 1);
+        if (i0 > i1)
+            continue;
+
+        const uint64_t* bits = mask.data() + (size_t)j * mask_stride;
+        for (int k = i0 / 64; k <= i1 / 64; k++) {
+            // the bits of this word from i0 to i1
+            int first = k == i0 / 64 ? i0 % 64 : 0;
+            int last = k == i1 / 64 ? i1 % 64 : 63;
+            uint64_t covered = (~(uint64_t)0 >> (63 - last + first)) << first;
+            if (bits[k] & covered)
+                return true;
+        }
+    }
+    return false;
+}
+
+int Image::width() const {
+    return w;
+}
+
+int Image::height() const {
+    return h;
+}
+
+const uint32_t* Image::row(int y) const {
+    return pixels.data() + (size_t)y * w;
 }
 
 void Image::render(int x, int y, float theta) const {
     x -= w / 2;
     y -= h / 2;
 
-    // TODO: rotate using better algorithm, maybe this:
-    // https://github.com/adnanlah/rotsprite-webgl/blob/master/src/utils/RotspriteAlgoJS.ts
+    if (theta == 0) {
+        // clip the image against the screen once, rather than every pixel
+        int x0 = std::max(x, 0);
+        int x1 = std::min(x + w, framebuffer->width());
+        int y0 = std::max(y, 0);
+        int y1 = std::min(y + h, framebuffer->height());
+        if (x0 >= x1)
+            return;
+
+        framebuffer->mark_dirty(x0, y0, x1, y1);
+        for (int j = y0; j < y1; j++) {
+            const uint32_t* src = row(j - y) + (x0 - x);
+            uint32_t* dst = framebuffer->row(j) + x0;
+
+            if (opaque)
+                std::memcpy(dst, src, (x1 - x0) * sizeof(uint32_t));
+            else
+                blit_span(dst, src, x1 - x0);
+        }
+
+        return;
+    }
+
+    // Walk the destination bounding box of the rotated image row by row and
+    // map every destination pixel back into the image (inverse mapping), so
+    // rotated sprites have no holes. Source coordinates are 16.16 fixed point
+    // and only need an add per pixel, with one sin and cos per call.
+    const int32_t ONE = 1 << 16;
+    float c = std::cos(theta);
+    float s = std::sin(theta);
+
+    // pivot of the rotation in screenspace and in image space
+    float pivot_x = x + w / 2.0f;
+    float pivot_y = y + h / 2.0f;
+
+    float extent_x = (std::abs(c) * w + std::abs(s) * h) / 2.0f;
+    float extent_y = (std::abs(s) * w + std::abs(c) * h) / 2.0f;
+
+    int x0 = std::max((int)std::floor(pivot_x - extent_x), 0);
+    int x1 = std::min((int)std::ceil(pivot_x + extent_x), framebuffer->width());
+    int y0 = std::max((int)std::floor(pivot_y - extent_y), 0);
+    int y1 =
+        std::min((int)std::ceil(pivot_y + extent_y), framebuffer->height());
 
-    for (int i = 0; i < w; i++) {
-        for (int j = 0; j < h; j++) {
-            uint32_t color = colors->at(i)[j];
+    framebuffer->mark_dirty(x0, y0, x1, y1);
+
+    int32_t du = (int32_t)(c * ONE);
+    int32_t dv = (int32_t)(-s * ONE);
+
+    for (int j = y0; j < y1; j++) {
+        // image space coordinate of the center of the first pixel in the row
+        float dx = x0 + 0.5f - pivot_x;
+        float dy = j + 0.5f - pivot_y;
+        int32_t u = (int32_t)((w / 2.0f + c * dx + s * dy) * ONE);
+        int32_t v = (int32_t)((h / 2.0f - s * dx + c * dy) * ONE);
+
+        uint32_t* dst = framebuffer->row(j);
+        for (int i = x0; i < x1; i++, u += du, v += dv) {
+            // negative coordinates wrap around and fail the bounds check
+            uint32_t si = u >> 16;
+            uint32_t sj = v >> 16;
+            if (si >= (uint32_t)w || sj >= (uint32_t)h)
+                continue;
+            uint32_t color = pixels[(size_t)sj * w + si];
 
             // dont draw transparent pixels
-            if (color << 24 == 0x00)
+            if ((color >> 24) < OPAQUE_ALPHA)
                 continue;
 
-            Vector2 node = {(float)i, (float)j};
-            Vector2 center = {(float)w / 2, (float)h / 2};
-            Vector2 rot = {
-                center.x + (node.x - center.x) * cos(theta) -
-                    (node.y - center.y) * sin(theta),
-                center.y + (node.x - center.x) * sin(theta) +
-                    (node.y - center.y) * cos(theta),
-            };
-
-            LCD.SetFontColor(color);
-            draw_pixel_in_bounds(x + rot.x, y + rot.y);
+            dst[i] = color;
+        }
+    }
+}
+
+/// Scale an image up by 2x with the Scale2x (EPX) pixel art algorithm, which
+/// only ever copies existing colors so edges stay sharp
+/// @param src row-major pixels of the image
+/// @param w width in pixels of the image
+/// @param h height in pixels of the image
+/// @return row-major pixels of the 2w by 2h result
+static PixelBuffer scale2x(const PixelBuffer& src, int w, int h) {
+    PixelBuffer dst((size_t)w * h * 4);
+    size_t dst_w = (size_t)w * 2;
+
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            uint32_t p = src[(size_t)j * w + i];
+            uint32_t a = src[(size_t)std::max(j - 1, 0) * w + i];
+            uint32_t b = src[(size_t)j * w + std::min(i + 1, w - 1)];
+            uint32_t c = src[(size_t)j * w + std::max(i - 1, 0)];
+            uint32_t d = src[(size_t)std::min(j + 1, h - 1) * w + i];
+
+            uint32_t* top = dst.data() + (size_t)j * 2 * dst_w + i * 2;
+            uint32_t* bottom = top + dst_w;
+            top[0] = c == a && c != d && a != b ? a : p;
+            top[1] = a == b && a != c && b != d ? b : p;
+            bottom[0] = d == c && d != b && c != a ? c : p;
+            bottom[1] = b == d && b != a && d != c ? d : p;
         }
     }
+
+    return dst;
 }
 
-// include each of the generated header files for each image
-#include "build/assets/apple-left.png.h"
-#include "build/assets/apple-right.png.h"
-#include "build/assets/apple.png.h"
-#include "build/assets/background-menu.png.h"
-#include "build/assets/bananas-left.png.h"
-#include "build/assets/bananas-right.png.h"
-#include "build/assets/bananas.png.h"
-#include "build/assets/bomb.png.h"
-#include "build/assets/cherries-left.png.h"
-#include "build/assets/cherries-right.png.h"
-#include "build/assets/cherries.png.h"
-#include "build/assets/orange-left.png.h"
-#include "build/assets/orange-right.png.h"
-#include "build/assets/orange.png.h"
-#include "build/assets/pineapple-left.png.h"
-#include "build/assets/pineapple-right.png.h"
-#include "build/assets/pineapple.png.h"
-#include "build/assets/strawberry-left.png.h"
-#include "build/assets/strawberry-right.png.h"
-#include "build/assets/strawberry.png.h"
+Image Image::rotsprite(float theta) const {
+    // three passes of Scale2x
+    const int SCALE = 8;
+    PixelBuffer big = pixels;
+    int big_w = w, big_h = h;
+    for (int scale = 1; scale < SCALE; scale *= 2) {
+        big = scale2x(big, big_w, big_h);
+        big_w *= 2;
+        big_h *= 2;
+    }
+
+    float c = std::cos(theta);
+    float s = std::sin(theta);
+
+    // keep the same parity as the original size so the center of the result
+    // lands on the same pixel when rendered (the epsilon stops rounding error
+    // at right angles from growing the result)
+    const float EPSILON = 1e-3f;
+    int out_w = (int)std::ceil(std::abs(c) * w + std::abs(s) * h - EPSILON);
+    int out_h = (int)std::ceil(std::abs(s) * w + std::abs(c) * h - EPSILON);
+    out_w += (out_w - w) & 1;
+    out_h += (out_h - h) & 1;
+
+    // rotate and downscale in one step by sampling the upscaled image once
+    // under the center of every output pixel
+    PixelBuffer out((size_t)out_w * out_h);
+    for (int j = 0; j < out_h; j++) {
+        for (int i = 0; i < out_w; i++) {
+            float dx = i + 0.5f - out_w / 2.0f;
+            float dy = j + 0.5f - out_h / 2.0f;
+            int u = (int)std::floor((w / 2.0f + c * dx + s * dy) * SCALE);
+            int v = (int)std::floor((h / 2.0f - s * dx + c * dy) * SCALE);
+
+            if (u >= 0 && u < big_w && v >= 0 && v < big_h)
+                out[(size_t)j * out_w + i] = big[(size_t)v * big_w + u];
+        }
+    }
+
+    return Image(out_w, out_h, std::move(out));
+}
+
+// the generated header files for each image
+#include "build/assets/sprite-data.h"
 
 /// Initialize the image repository with images loaded into code directly so
 /// that it is statically included within the binary.
 ImageRepository::ImageRepository() {
-    images["assets/apple.png"] =
-        std::make_shared<Image>(assets_apple_png, assets_apple_png_len);
-    images["assets/apple-left.png"] = std::make_shared<Image>(
-        assets_apple_left_png, assets_apple_left_png_len);
-    images["assets/apple-right.png"] = std::make_shared<Image>(
-        assets_apple_right_png, assets_apple_right_png_len);
-
-    images["assets/bananas.png"] =
-        std::make_shared<Image>(assets_bananas_png, assets_bananas_png_len);
-    images["assets/bananas-left.png"] = std::make_shared<Image>(
-        assets_bananas_left_png, assets_bananas_left_png_len);
-    images["assets/bananas-right.png"] = std::make_shared<Image>(
-        assets_bananas_right_png, assets_bananas_right_png_len);
-
-    images["assets/orange.png"] =
-        std::make_shared<Image>(assets_orange_png, assets_orange_png_len);
-    images["assets/orange-left.png"] = std::make_shared<Image>(
-        assets_orange_left_png, assets_orange_left_png_len);
-    images["assets/orange-right.png"] = std::make_shared<Image>(
-        assets_orange_right_png, assets_orange_right_png_len);
-
-    images["assets/cherries.png"] =
-        std::make_shared<Image>(assets_cherries_png, assets_cherries_png_len);
-    images["assets/cherries-left.png"] = std::make_shared<Image>(
-        assets_cherries_left_png, assets_cherries_left_png_len);
-    images["assets/cherries-right.png"] = std::make_shared<Image>(
-        assets_cherries_right_png, assets_cherries_right_png_len);
-
-    images["assets/strawberry.png"] = std::make_shared<Image>(
-        assets_strawberry_png, assets_strawberry_png_len);
-    images["assets/strawberry-left.png"] = std::make_shared<Image>(
-        assets_strawberry_left_png, assets_strawberry_left_png_len);
-    images["assets/strawberry-right.png"] = std::make_shared<Image>(
-        assets_strawberry_right_png, assets_strawberry_right_png_len);
-
-    images["assets/pineapple.png"] =
-        std::make_shared<Image>(assets_pineapple_png, assets_pineapple_png_len);
-    images["assets/pineapple-left.png"] = std::make_shared<Image>(
-        assets_pineapple_left_png, assets_pineapple_left_png_len);
-    images["assets/pineapple-right.png"] = std::make_shared<Image>(
-        assets_pineapple_right_png, assets_pineapple_right_png_len);
-
-    images["assets/bomb.png"] =
-        std::make_shared<Image>(assets_bomb_png, assets_bomb_png_len);
-
-    images["assets/background-menu.png"] = std::make_shared<Image>(
-        assets_background_menu_png, assets_background_menu_png_len);
+    // reserved up front, since rotations and load_image hold on to the
+    // address of each sprite
+    sprites.reserve(SPRITE_COUNT);
+
+    // load_image of a built in sprite's path finds the same image, without
+    // owning it
+#define X(id, path, data)                                           \
+    sprites.emplace_back(data, data##_len);                         \
+    images[path] = std::shared_ptr<Image>(std::shared_ptr<Image>(), \
+                                          &sprites.back());
+    SPRITES(X)
+#undef X
 }
 
 std::shared_ptr<Image> ImageRepository::load_image(std::string filename) {
@@ -170,3 +335,61 @@ std::shared_ptr<Image> ImageRepository::load_image(std::string filename) {
 
     return images[filename];
 }
+
+/// Number of bytes of pixels an image uses
+/// @param image image to measure
+static size_t image_size(const Image& image) {
+    return (size_t)image.width() * image.height() * sizeof(uint32_t);
+}
+
+const Image& ImageRepository::rotated(const Image& image, float theta) {
+    size_t steps = std::max(config.rotation_steps, (size_t)1);
+    if (steps != rotations_steps) {
+        clear_rotations();
+        rotations_steps = steps;
+    }
+
+    // quantize the angle to the closest step in [0, steps)
+    float turns = theta / (2 * PI);
+    size_t step =
+        (size_t)std::lround((turns - std::floor(turns)) * steps) % steps;
+    if (step == 0)
+        return image;
+
+    std::vector<RotationFrame>& frames = rotations[&image];
+    if (frames.empty())
+        frames.resize(steps);
+
+    RotationFrame& frame = frames[step];
+    if (frame.image) {
+        rotations_lru.splice(rotations_lru.begin(), rotations_lru, frame.lru);
+        return *frame.image;
+    }
+
+    frame.image =
+        std::make_unique<Image>(image.rotsprite(step * 2 * PI / steps));
+    frame.lru = rotations_lru.insert(rotations_lru.begin(), {&image, step});
+    rotations_size += image_size(*frame.image);
+
+    // evict the least recently used rotations, but always keep the new one
+    while (rotations_size > config.rotation_cache_budget &&
+           rotations_lru.size() > 1) {
+        RotationKey key = rotations_lru.back();
+        RotationFrame& victim = rotations.at(key.first)[key.second];
+        rotations_size -= image_size(*victim.image);
+        victim.image.reset();
+        rotations_lru.pop_back();
+    }
+
+    return *frame.image;
+}
+
+size_t ImageRepository::rotation_cache_size() const {
+    return rotations_size;
+}
+
+void ImageRepository::clear_rotations() {
+    rotations.clear();
+    rotations_lru.clear();
+    rotations_size = 0;
+}
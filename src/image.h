@@ -4,11 +4,18 @@
 /// @author Mark Bundschuh
 /// @brief Image rendering and loading
 
+#include <cstdint>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "blit.h"
+#include "sprites.h"
+#include "util.h"
+
 /// Render an image (.png, .jpeg, etc.)
 class Image {
    public:
@@ -19,14 +26,84 @@ class Image {
     /// Render the image to the screen
     /// @param x x coordinate to draw the image at
     /// @param y y coordinate to draw the image at
-    /// @param theta angle in radians to rotate about the center of image
+    /// @param theta angle in radians to rotate about the center of image,
+    /// taking the closest source pixel for each pixel drawn
     void render(int x, int y, float theta) const;
 
+    /// Create an image from an encoded file already in memory
+    /// @param data encoded image bytes (.png, .jpeg, etc.)
+    /// @param data_len length of data in bytes
     Image(const unsigned char* data, size_t data_len);
 
+    /// Create an image from decoded pixels
+    /// @param width width in pixels
+    /// @param height height in pixels
+    /// @param pixels row-major 0xAARRGGBB pixels, width * height in length
+    Image(int width, int height, PixelBuffer pixels);
+
+    /// Rotate the image with the RotSprite algorithm: upscale 8x with Scale2x
+    /// (which keeps pixel art edges sharp), rotate, then downscale again. This
+    /// is far too slow to run every frame but looks much better than rotating
+    /// directly, so the results are cached in the ImageRepository.
+    /// @param theta angle in radians to rotate about the center of the image
+    /// @return new image, large enough to hold the whole rotated image, with
+    /// the same center
+    Image rotsprite(float theta) const;
+
+    /// Width in pixels of the image
+    int width() const;
+
+    /// Height in pixels of the image
+    int height() const;
+
+    /// Retrieve a row of the image
+    /// @param y row index in [0, height)
+    /// @return pointer to the first of width() contiguous 0xAARRGGBB pixels
+    const uint32_t* row(int y) const;
+
+    /// Distance from the center of the image to the furthest corner of any
+    /// opaque pixel, so a circle this big covers everything drawn at any
+    /// rotation
+    float reach() const { return reach_radius; }
+
+    /// Whether a line segment passes through any opaque pixel of the image as
+    /// it is drawn rotated, tested against the image's opacity mask a row of
+    /// 64 pixels at a time
+    /// @param p1 first endpoint, in pixels from where the center of the image
+    /// is drawn
+    /// @param p2 last endpoint, in pixels from where the center of the image
+    /// is drawn
+    /// @param theta angle in radians the image is rotated about its center
+    bool segment_hits(Vector2 p1, Vector2 p2, float theta) const;
+
    private:
+    /// Convert 8 bit RGBA output from stb_image into the pixel buffer
+    /// @param image pixels returned by stbi_load with 4 requested components
+    void load(const unsigned char* image);
+
+    /// Work out the opacity mask, row spans, and reach from the pixels
+    void build_mask();
+
     int w, h, channelCount;
-    std::unique_ptr<std::vector<std::vector<uint32_t>>> colors;
+    /// Whether every pixel is fully opaque, so rows can be copied wholesale
+    bool opaque;
+    /// Row-major pixels, w * h in length
+    PixelBuffer pixels;
+
+    /// First and one past the last opaque column of a row, which are equal
+    /// when there are none
+    struct RowSpan {
+        int begin, end;
+    };
+
+    /// One bit per pixel of whether it is opaque, with each row starting on a
+    /// new word and pixel i of a row at bit i % 64 of word i / 64
+    std::vector<uint64_t> mask;
+    /// Number of words in each row of mask
+    int mask_stride = 0;
+    /// Opaque columns of each row
+    std::vector<RowSpan> spans;
+    float reach_radius = 0;
 };
 
 /// Optimized Image storage and loading
@@ -35,12 +112,56 @@ class ImageRepository {
     /// Default constructor
     ImageRepository();
 
-    /// Load an image from the path
+    /// Load an image from the path. Sprites built into the game are found
+    /// without touching the file system.
     /// @param filename path to image file (.png, .jpeg, etc.) to load
     std::shared_ptr<Image> load_image(std::string filename);
 
+    /// Sprite built into the game
+    /// @param id which sprite
+    const Image& sprite(SpriteId id) const { return sprites[(size_t)id]; }
+
+    /// Retrieve a pre-rotated copy of an image, rendering it with RotSprite the
+    /// first time each quantized angle is asked for. Rendering the result with
+    /// no rotation is a straight blit.
+    /// @see Config::rotation_steps for how angles are quantized
+    /// @see Config::rotation_cache_budget for how much memory may be used
+    /// @param image image to rotate
+    /// @param theta angle in radians to rotate about the center of the image
+    /// @return rotated image, only valid until the next call
+    const Image& rotated(const Image& image, float theta);
+
+    /// Number of bytes of pixels in the rotation cache
+    size_t rotation_cache_size() const;
+
+    /// Throw out every cached rotation. Call this before destroying an image
+    /// which was rotated, since rotations are keyed by the image's address.
+    void clear_rotations();
+
    private:
+    /// Key of a cached rotation: the image and its quantized angle
+    typedef std::pair<const Image*, size_t> RotationKey;
+
+    /// A cached rotation of an image
+    struct RotationFrame {
+        std::unique_ptr<Image> image;
+        /// Position in the least recently used list
+        std::list<RotationKey>::iterator lru;
+    };
+
+    /// Every sprite built into the game, indexed by SpriteId
+    std::vector<Image> sprites;
+
     std::unordered_map<std::string, std::shared_ptr<Image>> images;
+
+    /// Rotations of each image, indexed by quantized angle
+    std::unordered_map<const Image*, std::vector<RotationFrame>> rotations;
+    /// Cached rotations, most recently used first
+    std::list<RotationKey> rotations_lru;
+    /// Number of bytes of pixels in the rotation cache
+    size_t rotations_size = 0;
+    /// Number of quantized angles the cache was built with
+    size_t rotations_steps = 0;
 };
 
 /// Global variable to hold the image repository
@@ -0,0 +1,155 @@
+/// @file integrate.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of the integration kernel, with AVX2 and SSE2
+/// versions picked at compile time and a scalar fallback for everything else
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "integrate.h"
+
+/// Advance bodies one at a time, the same way as the vector versions
+/// @param b columns to update
+/// @param first first body to update
+/// @param n one past the last body to update
+/// @param gravity downward acceleration in pixels per second squared
+/// @param dt length in seconds of each step
+/// @param steps number of steps to take, at least 1
+static void integrate_range(const BodyColumns& b,
+                            size_t first,
+                            size_t n,
+                            float gravity,
+                            float dt,
+                            uint32_t steps) {
+    for (size_t i = first; i < n; i++) {
+        float x = b.x[i], y = b.y[i];
+        float vx = b.vx[i], vy = b.vy[i];
+        float ax = b.ax[i], ay = b.ay[i] + gravity;
+
+        for (uint32_t s = 0; s < steps; s++) {
+            if (s + 1 == steps) {
+                b.prev_x[i] = x;
+                b.prev_y[i] = y;
+                b.prev_vx[i] = vx;
+                b.prev_vy[i] = vy;
+            }
+
+            vx += ax * dt;
+            vy += ay * dt;
+            x += vx * dt;
+            y += vy * dt;
+
+            ax = 0;
+            ay = gravity;
+        }
+
+        b.x[i] = x;
+        b.y[i] = y;
+        b.vx[i] = vx;
+        b.vy[i] = vy;
+        b.ax[i] = 0;
+        b.ay[i] = 0;
+    }
+}
+
+void integrate(const BodyColumns& b,
+               size_t n,
+               float gravity,
+               float dt,
+               uint32_t steps) {
+    size_t i = 0;
+
+    // every version does the same operations in the same order, so results
+    // do not depend on which one a body goes through
+
+#if defined(__AVX2__)
+    const __m256 g8 = _mm256_set1_ps(gravity);
+    const __m256 dt8 = _mm256_set1_ps(dt);
+    const __m256 zero8 = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(b.x + i);
+        __m256 y = _mm256_loadu_ps(b.y + i);
+        __m256 vx = _mm256_loadu_ps(b.vx + i);
+        __m256 vy = _mm256_loadu_ps(b.vy + i);
+        __m256 ax = _mm256_loadu_ps(b.ax + i);
+        __m256 ay = _mm256_add_ps(_mm256_loadu_ps(b.ay + i), g8);
+
+        for (uint32_t s = 0; s < steps; s++) {
+            if (s + 1 == steps) {
+                _mm256_storeu_ps(b.prev_x + i, x);
+                _mm256_storeu_ps(b.prev_y + i, y);
+                _mm256_storeu_ps(b.prev_vx + i, vx);
+                _mm256_storeu_ps(b.prev_vy + i, vy);
+            }
+
+            vx = _mm256_add_ps(vx, _mm256_mul_ps(ax, dt8));
+            vy = _mm256_add_ps(vy, _mm256_mul_ps(ay, dt8));
+            x = _mm256_add_ps(x, _mm256_mul_ps(vx, dt8));
+            y = _mm256_add_ps(y, _mm256_mul_ps(vy, dt8));
+
+            // impulses only last for the first step
+            ax = zero8;
+            ay = g8;
+        }
+
+        _mm256_storeu_ps(b.x + i, x);
+        _mm256_storeu_ps(b.y + i, y);
+        _mm256_storeu_ps(b.vx + i, vx);
+        _mm256_storeu_ps(b.vy + i, vy);
+        _mm256_storeu_ps(b.ax + i, zero8);
+        _mm256_storeu_ps(b.ay + i, zero8);
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128 g4 = _mm_set1_ps(gravity);
+    const __m128 dt4 = _mm_set1_ps(dt);
+    const __m128 zero4 = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(b.x + i);
+        __m128 y = _mm_loadu_ps(b.y + i);
+        __m128 vx = _mm_loadu_ps(b.vx + i);
+        __m128 vy = _mm_loadu_ps(b.vy + i);
+        __m128 ax = _mm_loadu_ps(b.ax + i);
+        __m128 ay = _mm_add_ps(_mm_loadu_ps(b.ay + i), g4);
+
+        for (uint32_t s = 0; s < steps; s++) {
+            if (s + 1 == steps) {
+                _mm_storeu_ps(b.prev_x + i, x);
+                _mm_storeu_ps(b.prev_y + i, y);
+                _mm_storeu_ps(b.prev_vx + i, vx);
+                _mm_storeu_ps(b.prev_vy + i, vy);
+            }
+
+            vx = _mm_add_ps(vx, _mm_mul_ps(ax, dt4));
+            vy = _mm_add_ps(vy, _mm_mul_ps(ay, dt4));
+            x = _mm_add_ps(x, _mm_mul_ps(vx, dt4));
+            y = _mm_add_ps(y, _mm_mul_ps(vy, dt4));
+
+            ax = zero4;
+            ay = g4;
+        }
+
+        _mm_storeu_ps(b.x + i, x);
+        _mm_storeu_ps(b.y + i, y);
+        _mm_storeu_ps(b.vx + i, vx);
+        _mm_storeu_ps(b.vy + i, vy);
+        _mm_storeu_ps(b.ax + i, zero4);
+        _mm_storeu_ps(b.ay + i, zero4);
+    }
+#endif
+
+    integrate_range(b, i, n, gravity, dt, steps);
+}
+
+void integrate_scalar(const BodyColumns& b,
+                      size_t n,
+                      float gravity,
+                      float dt,
+                      uint32_t steps) {
+    integrate_range(b, 0, n, gravity, dt, steps);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+/// @file integrate.h
+/// @author Mark Bundschuh
+/// @brief Batch physics integration kernel
+
+#include <cstddef>
+#include <cstdint>
+
+/// Columns of the bodies advanced by integrate, each at least n long
+struct BodyColumns {
+    float *x, *y, *vx, *vy;
+    float *prev_x, *prev_y, *prev_vx, *prev_vy;
+    /// Acceleration from impulse forces, applied during the first step only
+    /// and cleared afterwards
+    float *ax, *ay;
+};
+
+/// Advance a batch of bodies by some number of semi-implicit Euler steps under
+/// gravity. The state before the last step is left in the prev columns, so
+/// rendering can interpolate across it. Running several steps in one call
+/// keeps every body in registers until all of them are done.
+/// @param bodies columns to update
+/// @param n number of bodies
+/// @param gravity downward acceleration in pixels per second squared
+/// @param dt length in seconds of each step
+/// @param steps number of steps to take, at least 1
+void integrate(const BodyColumns& bodies,
+               size_t n,
+               float gravity,
+               float dt,
+               uint32_t steps);
+
+/// One body at a time version of integrate, which the vector versions have to
+/// match exactly (checked by `bench.out --check`)
+/// @param bodies columns to update
+/// @param n number of bodies
+/// @param gravity downward acceleration in pixels per second squared
+/// @param dt length in seconds of each step
+/// @param steps number of steps to take, at least 1
+void integrate_scalar(const BodyColumns& bodies,
+                      size_t n,
+                      float gravity,
+                      float dt,
+                      uint32_t steps);
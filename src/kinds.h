@@ -0,0 +1,156 @@
+#pragma once
+
+/// @file kinds.h
+/// @author Mark Bundschuh
+/// @brief Compile-time list of every kind of thrown object and what it does
+
+#include <cstddef>
+#include <cstdint>
+
+#include "entities.h"
+#include "sprites.h"
+
+class Game;
+
+/// What fruits do when the knife hits them: split into two shards, splash
+/// juice, and score. Kinds cut this way also have left and right sprites for
+/// their halves, and the color of their juice as 0xRRGGBB.
+struct SliceInHalf {
+    /// Cut an entity of some kind
+    /// @tparam Kind kind of the entity
+    /// @param game game the entity is in
+    /// @param i index of the entity
+    /// @return whether the knife carries on cutting
+    template <typename Kind>
+    static bool cut(Game& game, size_t i);
+};
+
+/// What bombs do when the knife hits them: blow up and end the game
+struct Explode {
+    /// Blow up an entity of some kind
+    /// @tparam Kind kind of the entity
+    /// @param game game the entity is in
+    /// @param i index of the entity
+    /// @return whether the knife carries on cutting
+    template <typename Kind>
+    static bool cut(Game& game, size_t i);
+};
+
+/// Properties every fruit shares. A kind of thrown object is a type with these
+/// members, its EntityType, its whole sprite, and whatever else its Cut needs.
+struct Fruit {
+    /// Collision radius in pixels
+    static constexpr float radius = 13;
+    /// Mass, which sets how hard it is thrown
+    static constexpr float mass = 8;
+    /// Whether it is thrown at random as a fruit, rather than by chance as a
+    /// bomb
+    static constexpr bool fruit = true;
+    /// What happens when the knife hits it
+    using Cut = SliceInHalf;
+};
+
+struct Apple : Fruit {
+    static constexpr EntityType type = EntityType::Apple;
+    static constexpr SpriteId whole = SpriteId::Apple;
+    static constexpr SpriteId left = SpriteId::AppleLeft;
+    static constexpr SpriteId right = SpriteId::AppleRight;
+    static constexpr uint32_t juice = 0xC0282D;
+};
+
+struct Bananas : Fruit {
+    static constexpr EntityType type = EntityType::Bananas;
+    static constexpr SpriteId whole = SpriteId::Bananas;
+    static constexpr SpriteId left = SpriteId::BananasLeft;
+    static constexpr SpriteId right = SpriteId::BananasRight;
+    static constexpr uint32_t juice = 0xF5D33F;
+};
+
+struct Orange : Fruit {
+    static constexpr EntityType type = EntityType::Orange;
+    static constexpr SpriteId whole = SpriteId::Orange;
+    static constexpr SpriteId left = SpriteId::OrangeLeft;
+    static constexpr SpriteId right = SpriteId::OrangeRight;
+    static constexpr uint32_t juice = 0xF5901E;
+};
+
+struct Cherries : Fruit {
+    static constexpr EntityType type = EntityType::Cherries;
+    static constexpr SpriteId whole = SpriteId::Cherries;
+    static constexpr SpriteId left = SpriteId::CherriesLeft;
+    static constexpr SpriteId right = SpriteId::CherriesRight;
+    static constexpr uint32_t juice = 0x9E1030;
+};
+
+struct Strawberry : Fruit {
+    static constexpr EntityType type = EntityType::Strawberry;
+    static constexpr SpriteId whole = SpriteId::Strawberry;
+    static constexpr SpriteId left = SpriteId::StrawberryLeft;
+    static constexpr SpriteId right = SpriteId::StrawberryRight;
+    static constexpr uint32_t juice = 0xE0283C;
+};
+
+struct Pineapple : Fruit {
+    static constexpr EntityType type = EntityType::Pineapple;
+    static constexpr SpriteId whole = SpriteId::Pineapple;
+    static constexpr SpriteId left = SpriteId::PineappleLeft;
+    static constexpr SpriteId right = SpriteId::PineappleRight;
+    static constexpr uint32_t juice = 0xF2C53D;
+};
+
+struct Bomb {
+    static constexpr EntityType type = EntityType::Bomb;
+    static constexpr SpriteId whole = SpriteId::Bomb;
+    static constexpr float radius = Fruit::radius;
+    static constexpr float mass = Fruit::mass;
+    static constexpr bool fruit = false;
+    using Cut = Explode;
+};
+
+/// A list of kinds of thrown objects, which stamps out code for each of them
+/// @tparam Kinds every kind, in EntityType order
+template <typename... Kinds>
+struct KindList {
+    /// Number of kinds
+    static constexpr size_t size = sizeof...(Kinds);
+
+    /// Number of kinds which are fruits
+    static constexpr size_t fruits = (0 + ... + (size_t)Kinds::fruit);
+
+    /// Call a function with the kind of an entity
+    /// @param type what the entity is
+    /// @param f function taking a value of the kind and returning a bool
+    /// @return what f returned, or false if type is not in the list
+    template <typename F>
+    static bool visit(EntityType type, F&& f) {
+        bool result = false;
+        (void)((Kinds::type == type && (result = f(Kinds()), true)) || ...);
+        return result;
+    }
+
+    /// Which kind is the nth fruit
+    /// @param n index among the fruits, less than fruits
+    static constexpr EntityType fruit(size_t n) {
+        EntityType type = EntityType::Shard;
+        (void)((Kinds::fruit && n-- == 0 && (type = Kinds::type, true)) ||
+               ...);
+        return type;
+    }
+
+    /// Whether every kind's position in the list is its EntityType, so
+    /// anything indexed by one can be indexed by the other
+    static constexpr bool in_order() {
+        size_t i = 0;
+        return (... && ((size_t)Kinds::type == i++));
+    }
+};
+
+/// Every kind of thrown object. Adding a kind means adding it here, to
+/// EntityType, and its sprites to assets/.
+using ThrowableKinds =
+    KindList<Apple, Bananas, Orange, Cherries, Strawberry, Pineapple, Bomb>;
+
+static_assert(ThrowableKinds::size == THROWABLE_TYPES,
+              "every thrown EntityType needs a kind");
+static_assert(ThrowableKinds::in_order(),
+              "kinds must be listed in EntityType order");
@@ -7,11 +7,11 @@
 
 #include <FEHLCD.h>
 
-#include "game.h"
+#include "framebuffer.h"
 #include "knife.h"
 #include "util.h"
 
-Knife::Knife() {}
+Knife::Knife() : points(), tail(0), head(0), current_color(0) {}
 
 // Bresenham's line drawing algorithm which works for all points a and b
 void Knife::rainbow_draw_line(Point a, Point b) {
@@ -84,7 +84,7 @@ void Knife::rainbow_draw_line(Point a, Point b) {
 
 // Change font color to next one in a ranbow and makes cross
 void Knife::rainbow_dot(int x, int y) {
-    LCD.SetFontColor(colors[current_color]);
+    framebuffer->set_color(colors[current_color]);
     current_color++;
     if (current_color == 7) {
         current_color = 0;
@@ -108,20 +108,13 @@ void Knife::update() {
             rainbow_draw_line(p1, p2);
         }
 
-        if (head - tail > 1) {
-            auto p1 = points[(head - 0) % TAIL_LEN];
-            auto p2 = points[(head - 1) % TAIL_LEN];
-
-            game->collide_with_knife(Vector2(p1.x, p1.y), Vector2(p2.x, p2.y));
-        }
-
         if (head < tail + TAIL_LEN - 1) {
             head++;
         } else {
             tail++;
         }
 
-        LCD.SetFontColor(colors[0]);
+        framebuffer->set_color(colors[0]);
         fill_circle(touchX, touchY, 3);
 
     } else {
@@ -16,7 +16,6 @@ class Knife {
     /// Update and render the knife
     void update();
 
-   private:
     /// Primitive for a point on the screen
     struct Point {
         int x;
@@ -28,6 +27,7 @@ class Knife {
     /// @param b last endpoint of line to draw the rainbow line in screenspace
     void rainbow_draw_line(Point a, Point b);
 
+   private:
     /// Draw a colored dot in the rainbow cycle
     /// @param x screenspace x coordinate of where to draw the dot
     /// @param y screenspace y coordinate of where to draw the dot
@@ -6,47 +6,190 @@
 #include <FEHUtility.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
+#include "config.h"
+#include "framebuffer.h"
 #include "game.h"
 #include "menu.h"
+#include "profiler.h"
+#include "replay.h"
+#include "stress.h"
+#include "tasks.h"
 #include "ui.h"
 #include "util.h"
 
+/// Print the profiler's and entity pools' reports, registered to run at exit
+void print_profile() {
+    profiler->report(std::cerr);
+    game->entities.report(std::cerr);
+    game->particles.report(std::cerr);
+}
+
+/// Report on a replay which has finished playing and exit
+/// @param seconds wall time the replay took to play
+void finish_replay(double seconds) {
+    // FNV-1a of the final frame, so runs which should be identical can be
+    // checked
+    uint64_t checksum = 0xcbf29ce484222325;
+    for (int y = 0; y < framebuffer->height(); y++) {
+        const uint32_t* row = framebuffer->row(y);
+        for (int x = 0; x < framebuffer->width(); x++) {
+            checksum ^= row[x];
+            checksum *= 0x100000001b3;
+        }
+    }
+
+    char line[128];
+    std::snprintf(line, sizeof(line),
+                  "replay: %llu frames in %.3f s (%.1f fps), checksum %016llx",
+                  (unsigned long long)replay->frames(), seconds,
+                  replay->frames() / seconds, (unsigned long long)checksum);
+    std::cerr << line << std::endl;
+    std::exit(0);
+}
+
 /// Main function which is the entrypoint for the entire program
-int main() {
+/// @param argc number of command line arguments
+/// @param argv command line arguments. Pass --profile to show the frame time
+/// overlay and print a frame time report at exit, --stress to start the
+/// stress test instead of the menu, --ballistic to move thrown objects along
+/// their closed-form trajectories, --record <path> to record input to a file,
+/// and --replay <path> to play a recording back as fast as possible.
+int main(int argc, char** argv) {
     current_scene = menu;
 
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--profile") == 0) {
+            profiler->overlay_visible = true;
+            std::atexit(print_profile);
+        } else if (std::strcmp(argv[i], "--stress") == 0) {
+            current_scene = stress;
+        } else if (std::strcmp(argv[i], "--ballistic") == 0) {
+            config.ballistic_physics = true;
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            if (!replay->record(argv[++i])) {
+                std::cerr << "could not record to " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            if (!replay->play(argv[++i])) {
+                std::cerr << "could not replay " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if (current_scene == stress)
+        stress->start();
+
     // https://gafferongames.com/post/fix_your_timestep
     double t = 0.0;
     double dt = 0.01;
 
+    // time in seconds to wait after a frame where nothing changed
+    const double IDLE_SLEEP = 0.005;
+
     double current_time = TimeNow();
     double accumulator = 0.0;
+    bool playing = replay->mode() == Replay::Mode::Playing;
+    bool recording = replay->mode() == Replay::Mode::Recording;
+    auto replay_start = std::chrono::steady_clock::now();
 
     while (true) {
-        double new_time = TimeNow();
-        double frame_time = new_time - current_time;
-        if (frame_time > 0.25)
-            frame_time = 0.25;
-        current_time = new_time;
-
-        accumulator += frame_time;
+        // a replay keeps time in physics ticks, so it takes the number of
+        // ticks and the alpha of every frame from the recording instead of
+        // the clock
+        ReplayFrame frame;
+        uint32_t steps = 0;
+        if (playing) {
+            if (!replay->read(frame)) {
+                finish_replay(std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() -
+                                  replay_start)
+                                  .count());
+            }
+            steps = frame.ticks;
+        } else {
+            double new_time = TimeNow();
+            double frame_time = new_time - current_time;
+            if (frame_time > 0.25) {
+                profiler->drop_time(frame_time - 0.25);
+                frame_time = 0.25;
+            }
+            current_time = new_time;
 
-        while (accumulator >= dt) {
-            current_scene->physics_update(t, dt);
-            t += dt;
-            accumulator -= dt;
+            accumulator += frame_time;
+            while (accumulator >= dt) {
+                accumulator -= dt;
+                steps++;
+            }
         }
 
+        // touch is read before physics runs, so the steps can cut along where
+        // the knife went up until now
         double alpha = accumulator / dt;
 
-        touchPressed = LCD.Touch(&touchX, &touchY);
-        touchX = std::clamp(touchX, 0, (int)LCD_WIDTH);
-        touchY = std::clamp(touchY, 0, (int)LCD_HEIGHT);
-        LCD.Clear();
-        current_scene->update(alpha);
+        if (playing) {
+            alpha = Replay::alpha(frame.alpha);
+            touchPressed = frame.pressed;
+            touchX = frame.x;
+            touchY = frame.y;
+        } else {
+            touchPressed = LCD.Touch(&touchX, &touchY);
+            touchX = std::clamp(touchX, 0, (int)LCD_WIDTH);
+            touchY = std::clamp(touchY, 0, (int)LCD_HEIGHT);
+        }
+
+        if (recording) {
+            // render with the same alpha the replay will
+            frame = {steps, Replay::quantize_alpha(alpha), touchPressed, touchX,
+                     touchY};
+            alpha = Replay::alpha(frame.alpha);
+            replay->write(frame);
+        }
+
+        touchTime = t + (steps + alpha) * dt;
+        // the knife goes anywhere in a game, corners included, so holding it
+        // there never toggles the overlay
+        bool knife_active = current_scene == game && game->knife_enabled;
+        profiler->toggle_overlay_on_hold(touchPressed && !knife_active, touchX,
+                                         touchY, touchTime);
+
+        {
+            ScopedTimer timer(Phase::Physics);
+            current_scene->physics_steps(t, dt, steps);
+            for (uint32_t i = 0; i < steps; i++)
+                t += dt;
+        }
+        profiler->count_physics_steps(steps);
+
+        {
+            ScopedTimer timer(Phase::Update);
+            current_scene->update(alpha);
+            // effects draw over the scene, and any change of scene happens
+            // once the frame is done
+            scheduler->run(touchTime);
+            profiler->render_overlay();
+        }
+
+        bool presented;
+        {
+            ScopedTimer timer(Phase::Present);
+            presented = framebuffer->present();
+        }
+
+        // nothing on screen changed, so give the processor a break instead of
+        // spinning on a static screen (unless a replay is running flat out)
+        if (!presented && !playing)
+            Sleep(IDLE_SLEEP);
+
+        profiler->end_frame();
     }
 
     return 0;
@@ -12,9 +12,12 @@
 
 #include <FEHLCD.h>
 
+#include "framebuffer.h"
 #include "game.h"
 #include "image.h"
 #include "menu.h"
+#include "stress.h"
+#include "tasks.h"
 #include "ui.h"
 #include "util.h"
 
@@ -24,28 +27,29 @@ Credits::Credits() {
     box = std::make_unique<UIBox>(UIPosition(0, 0, UIPosition::Center),
                                   LCD_WIDTH - 10 * 2, LCD_HEIGHT - 10 * 2);
 
-    close_button->bind_on_button_up([&]() { current_scene = menu; });
+    close_button->bind_on_button_up(
+        [&]() { scheduler->change_scene(menu); });
 
     background = image_repository->load_image("assets/background-menu.png");
 }
 
 void Credits::update(double alpha) {
-    background->render(LCD_WIDTH / 2, LCD_HEIGHT / 2, 0);
+    framebuffer->draw_background(*background);
 
     box->update();
     constexpr uint64_t inner_padding = 10;
     uint64_t x = box->get_x() + inner_padding, y = box->get_y() + inner_padding;
     std::string title = "Credits";
-    LCD.WriteAt(title.c_str(), x, y);
-    LCD.DrawHorizontalLine(y + FONT_GLYPH_HEIGHT + 1, x,
-                           x + title.length() * FONT_GLYPH_WIDTH);
+    framebuffer->write_at(title, x, y);
+    framebuffer->draw_horizontal_line(y + FONT_GLYPH_HEIGHT + 1, x,
+                                      x + title.length() * FONT_GLYPH_WIDTH);
 
     constexpr uint64_t SPACING = FONT_GLYPH_HEIGHT + 2;
-    LCD.WriteAt("Mark Bundschuh", x, y + SPACING * 2);
-    LCD.WriteAt("John Ulm", x, y + SPACING * 3);
+    framebuffer->write_at("Mark Bundschuh", x, y + SPACING * 2);
+    framebuffer->write_at("John Ulm", x, y + SPACING * 3);
 
-    LCD.WriteAt("Autumn 2022", x, y + SPACING * 5);
-    LCD.WriteAt("ENGR 1281.02H (6989)", x, y + SPACING * 6);
+    framebuffer->write_at("Autumn 2022", x, y + SPACING * 5);
+    framebuffer->write_at("ENGR 1281.02H (6989)", x, y + SPACING * 6);
 
     close_button->update();
 }
@@ -56,28 +60,29 @@ Instructions::Instructions() {
     box = std::make_unique<UIBox>(UIPosition(0, 0, UIPosition::Center),
                                   LCD_WIDTH - 10 * 2, LCD_HEIGHT - 10 * 2);
 
-    close_button->bind_on_button_up([&]() { current_scene = menu; });
+    close_button->bind_on_button_up(
+        [&]() { scheduler->change_scene(menu); });
 
     background = image_repository->load_image("assets/background-menu.png");
 }
 
 void Instructions::update(double alpha) {
-    background->render(LCD_WIDTH / 2, LCD_HEIGHT / 2, 0);
+    framebuffer->draw_background(*background);
 
     box->update();
     constexpr uint64_t inner_padding = 10;
     uint64_t x = box->get_x() + inner_padding, y = box->get_y() + inner_padding;
     std::string title = "Instructions";
-    LCD.WriteAt(title.c_str(), x, y);
-    LCD.DrawHorizontalLine(y + FONT_GLYPH_HEIGHT + 1, x,
-                           x + title.length() * FONT_GLYPH_WIDTH);
+    framebuffer->write_at(title, x, y);
+    framebuffer->draw_horizontal_line(y + FONT_GLYPH_HEIGHT + 1, x,
+                                      x + title.length() * FONT_GLYPH_WIDTH);
 
     constexpr uint64_t SPACING = FONT_GLYPH_HEIGHT + 2;
-    LCD.WriteAt("Chop fruit and avoid", x, y + SPACING * 2);
-    LCD.WriteAt("bombs. Slice multiple", x, y + SPACING * 3);
-    LCD.WriteAt("fruit to get a combo", x, y + SPACING * 4);
-    LCD.WriteAt("and go for the high", x, y + SPACING * 5);
-    LCD.WriteAt("score!", x, y + SPACING * 6);
+    framebuffer->write_at("Chop fruit and avoid", x, y + SPACING * 2);
+    framebuffer->write_at("bombs. Slice multiple", x, y + SPACING * 3);
+    framebuffer->write_at("fruit to get a combo", x, y + SPACING * 4);
+    framebuffer->write_at("and go for the high", x, y + SPACING * 5);
+    framebuffer->write_at("score!", x, y + SPACING * 6);
 
     close_button->update();
 }
@@ -92,8 +97,14 @@ Leaderboard::Leaderboard() {
     std::string name, points;
     while (getline(leaderboard_csv, name, ',')) {
         getline(leaderboard_csv, points);
-        add_entry({.name = name, .points = std::stoull(points)});
+        entries.push_back({.name = name, .points = std::stoull(points)});
     }
+
+    // sort once instead of inserting (and rewriting the file) per entry, in
+    // the same order as inserting them one at a time would
+    std::stable_sort(
+        entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b) { return a.points > b.points; });
 }
 
 void Leaderboard::add_entry(Entry entry) {
@@ -103,10 +114,14 @@ void Leaderboard::add_entry(Entry entry) {
                          [](Entry a, Entry b) { return a.points > b.points; }),
         entry);
 
+    save();
+}
+
+void Leaderboard::save() const {
     // write leaderboard to file
     std::ofstream leaderboard_csv("leaderboard.csv");
     std::for_each(
-        entries.begin(), entries.end(), [&leaderboard_csv](Entry& entry) {
+        entries.begin(), entries.end(), [&leaderboard_csv](const Entry& entry) {
             leaderboard_csv << entry.name << "," << entry.points << "\n";
         });
 }
@@ -126,8 +141,8 @@ void Leaderboard::update() {
         uint64_t num_x = box->get_x() + box->width - inner_padding -
                          FONT_GLYPH_WIDTH * num.length();
 
-        LCD.WriteAt(entries[i].name.c_str(), name_x, y);
-        LCD.WriteAt(num.c_str(), num_x, y);
+        framebuffer->write_at(entries[i].name, name_x, y);
+        framebuffer->write_at(num, num_x, y);
     }
 }
 
@@ -138,6 +153,8 @@ Menu::Menu() {
         "Rules", UIPosition(118, 10, UIPosition::Anchor::BottomLeft));
     quit_button = std::make_unique<UIButton>(
         "Quit", UIPosition(10, 50, UIPosition::Anchor::BottomLeft));
+    stress_button = std::make_unique<UIButton>(
+        "Stress", UIPosition(88, 50, UIPosition::Anchor::BottomLeft));
     play_easy = std::make_unique<UIButton>(
         "Play (easy 1x)", UIPosition(10, 40, UIPosition::Anchor::TopLeft));
     play_medium = std::make_unique<UIButton>(
@@ -147,37 +164,43 @@ Menu::Menu() {
 
     background = image_repository->load_image("assets/background-menu.png");
 
-    show_credits_button->bind_on_button_up([&]() { current_scene = credits; });
+    show_credits_button->bind_on_button_up(
+        [&]() { scheduler->change_scene(credits); });
     show_instructions_button->bind_on_button_up(
-        [&]() { current_scene = instructions; });
+        [&]() { scheduler->change_scene(instructions); });
     quit_button->bind_on_button_up([&]() { exit(0); });
+    stress_button->bind_on_button_up([&]() {
+        scheduler->change_scene(stress);
+        stress->start();
+    });
     play_easy->bind_on_button_up([&]() {
-        current_scene = game;
+        scheduler->change_scene(game);
         game->start(0.12, 1);
     });
     play_medium->bind_on_button_up([&]() {
-        current_scene = game;
+        scheduler->change_scene(game);
         game->start(0.24, 2);
     });
     play_hard->bind_on_button_up([&]() {
-        current_scene = game;
+        scheduler->change_scene(game);
         game->start(0.36, 3);
     });
 }
 
 void Menu::update(double alpha) {
-    background->render(LCD_WIDTH / 2, LCD_HEIGHT / 2, 0);
+    framebuffer->draw_background(*background);
 
     uint64_t x = 20, y = 20;
     std::string title = "2 Fruity 4 You";
-    LCD.SetFontColor(WHITE);
-    LCD.WriteAt(title.c_str(), x, y);
-    LCD.DrawHorizontalLine(y + FONT_GLYPH_HEIGHT + 1, x,
-                           x + title.length() * FONT_GLYPH_WIDTH);
+    framebuffer->set_color(WHITE);
+    framebuffer->write_at(title, x, y);
+    framebuffer->draw_horizontal_line(y + FONT_GLYPH_HEIGHT + 1, x,
+                                      x + title.length() * FONT_GLYPH_WIDTH);
 
     show_credits_button->update();
     show_instructions_button->update();
     quit_button->update();
+    stress_button->update();
     play_easy->update();
     play_medium->update();
     play_hard->update();
@@ -66,6 +66,9 @@ class Leaderboard {
     void add_entry(Entry entry);
 
    private:
+    /// Write every entry to leaderboard.csv
+    void save() const;
+
     std::vector<Entry> entries;
     std::unique_ptr<UIBox> box;
 };
@@ -89,6 +92,7 @@ class Menu final : public Scene {
     std::unique_ptr<UIButton> show_credits_button;
     std::unique_ptr<UIButton> show_instructions_button;
     std::unique_ptr<UIButton> quit_button;
+    std::unique_ptr<UIButton> stress_button;
     std::unique_ptr<UIButton> play_easy;
     std::unique_ptr<UIButton> play_medium;
     std::unique_ptr<UIButton> play_hard;
@@ -0,0 +1,160 @@
+/// @file particles.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of pooled particles
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "framebuffer.h"
+#include "particles.h"
+#include "ui.h"
+
+void Particles::reserve(size_t capacity) {
+    pool_stats.capacity = capacity;
+    for_each_column([=](auto& column) { column.reserve(capacity); });
+}
+
+bool Particles::emit(Vector2 pos,
+                     Vector2 velocity,
+                     float gravity,
+                     float radius,
+                     uint32_t color,
+                     float life) {
+    if (pool_stats.live >= pool_stats.capacity) {
+        pool_stats.exhausted++;
+        return false;
+    }
+    pool_stats.live++;
+    pool_stats.high_water = std::max(pool_stats.high_water, pool_stats.live);
+
+    x.push_back(pos.x);
+    y.push_back(pos.y);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    this->gravity.push_back(gravity);
+    this->radius.push_back(radius);
+    this->life.push_back(life);
+    lifetime.push_back(life);
+    this->color.push_back(color);
+    return true;
+}
+
+void Particles::clear() {
+    for_each_column([](auto& column) { column.clear(); });
+    pool_stats.live = 0;
+}
+
+void Particles::physics_update(double dt, uint32_t steps) {
+    float step = dt;
+    for (uint32_t s = 0; s < steps; s++) {
+        for (size_t i = 0; i < size(); i++) {
+            vy[i] += gravity[i] * step;
+            x[i] += vx[i] * step;
+            y[i] += vy[i] * step;
+            life[i] -= step;
+        }
+    }
+
+    // the last particle takes the place of each one that died, and is checked
+    // next
+    size_t i = 0;
+    while (i < size()) {
+        if (life[i] > 0) {
+            i++;
+            continue;
+        }
+
+        size_t last = size() - 1;
+        if (i != last)
+            for_each_column([=](auto& column) { column[i] = column[last]; });
+        for_each_column([](auto& column) { column.pop_back(); });
+        pool_stats.live--;
+    }
+}
+
+/// Largest radius drawn from the table of disc spans, past which particles
+/// fall back to fill_circle
+static const int MAX_SPAN_RADIUS = 16;
+
+/// Half width of each row of a filled circle, indexed by radius and then by
+/// distance from the center row. Walks the same midpoint circle as
+/// fill_circle, so a particle covers exactly the pixels it used to.
+struct DiscSpans {
+    int8_t half[MAX_SPAN_RADIUS + 1][MAX_SPAN_RADIUS + 1] = {};
+
+    DiscSpans() {
+        for (int r = 0; r <= MAX_SPAN_RADIUS; r++) {
+            int8_t* row = half[r];
+            row[0] = r;
+
+            int f = 1 - r;
+            int ddF_x = 1;
+            int ddF_y = -2 * r;
+            int x = 0;
+            int y = r;
+            while (x < y) {
+                if (f >= 0) {
+                    y--;
+                    ddF_y += 2;
+                    f += ddF_y;
+                }
+                x++;
+                ddF_x += 2;
+                f += ddF_x;
+
+                // rows x away span y either side, and columns x away cover
+                // every row up to y away
+                row[x] = std::max<int>(row[x], y);
+                for (int dy = 0; dy <= y; dy++)
+                    row[dy] = std::max<int>(row[dy], x);
+            }
+        }
+    }
+};
+
+static const DiscSpans disc_spans;
+
+void Particles::render() const {
+    const int w = framebuffer->width();
+    const int h = framebuffer->height();
+
+    for (size_t i = 0; i < size(); i++) {
+        float r = radius[i] * life[i] / lifetime[i];
+        if (x[i] + r < 0 || x[i] - r > LCD_WIDTH || y[i] + r < 0 ||
+            y[i] - r > LCD_HEIGHT)
+            continue;
+
+        int cx = x[i];
+        int cy = y[i];
+        int ri = (int)(r + 0.5f);
+        if (ri > MAX_SPAN_RADIUS) {
+            framebuffer->set_color(color[i]);
+            fill_circle(cx, cy, ri);
+            continue;
+        }
+
+        // clip the disc's rows once, then fill each row's span straight into
+        // the framebuffer
+        int y1 = std::max(cy - ri, 0);
+        int y2 = std::min(cy + ri + 1, h);
+        int x1 = std::max(cx - ri, 0);
+        int x2 = std::min(cx + ri + 1, w);
+        if (y1 >= y2 || x1 >= x2)
+            continue;
+
+        const int8_t* half = disc_spans.half[ri];
+        for (int j = y1; j < y2; j++) {
+            int span = half[std::abs(j - cy)];
+            int left = std::max(cx - span, 0);
+            int right = std::min(cx + span + 1, w);
+            if (left < right)
+                std::fill(framebuffer->row(j) + left,
+                          framebuffer->row(j) + right, color[i]);
+        }
+        framebuffer->mark_dirty(x1, y1, x2, y2);
+    }
+}
+
+void Particles::report(std::ostream& out) const {
+    report_pool(out, "particle", pool_stats);
+}
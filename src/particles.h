@@ -0,0 +1,85 @@
+#pragma once
+
+/// @file particles.h
+/// @author Mark Bundschuh
+/// @brief Pooled particles for explosions, juice, and sparks
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "entities.h"
+#include "util.h"
+
+/// Short lived dots which fly off, slow down under gravity or not, and shrink
+/// away, stored as a structure of arrays in a pool of fixed size. Particles
+/// only move in physics steps and are drawn with the rest of the frame, so
+/// effects never hold up the game.
+class Particles {
+   public:
+    /// Number of particles
+    size_t size() const { return x.size(); }
+
+    /// Set how many particles there is room for and allocate all of it up
+    /// front, so that emitting never allocates
+    /// @param capacity most particles alive at once
+    void reserve(size_t capacity);
+
+    /// Add a particle
+    /// @param pos screenspace position to start at
+    /// @param velocity velocity in pixels per second
+    /// @param gravity downward acceleration in pixels per second squared
+    /// @param radius radius in pixels when emitted, which shrinks to nothing
+    /// over its life
+    /// @param color color as 0xRRGGBB
+    /// @param life seconds until it disappears
+    /// @return whether there was room for it
+    bool emit(Vector2 pos,
+              Vector2 velocity,
+              float gravity,
+              float radius,
+              uint32_t color,
+              float life);
+
+    /// Remove every particle
+    void clear();
+
+    /// Move and age every particle by semi-implicit Euler steps, and remove
+    /// the ones whose life has run out
+    /// @param dt physics timestep
+    /// @param steps number of timesteps to advance by
+    void physics_update(double dt, uint32_t steps = 1);
+
+    /// Draw every particle on screen into the framebuffer
+    void render() const;
+
+    /// How full the pool is and has been
+    const PoolStats& stats() const { return pool_stats; }
+
+    /// Write how full the pool has been, in the same form as
+    /// Entities::report
+    /// @param out stream to write to
+    void report(std::ostream& out) const;
+
+    /// Position and velocity
+    std::vector<float> x, y, vx, vy;
+    /// Downward acceleration of each particle
+    std::vector<float> gravity;
+    /// Radius when emitted
+    std::vector<float> radius;
+    /// Seconds left to live, and seconds each had to live when emitted
+    std::vector<float> life, lifetime;
+    std::vector<uint32_t> color;
+
+   private:
+    PoolStats pool_stats;
+
+    /// Call a function on every column
+    /// @param f function taking a reference to a column
+    template <typename F>
+    void for_each_column(F f) {
+        f(x), f(y), f(vx), f(vy);
+        f(gravity), f(radius), f(life), f(lifetime), f(color);
+    }
+};
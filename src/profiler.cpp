@@ -0,0 +1,213 @@
+/// @file profiler.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of frame time instrumentation
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+
+#include "framebuffer.h"
+#include "profiler.h"
+#include "ui.h"
+
+/// Short names of each phase, for the overlay and report
+static const char* PHASE_NAMES[] = {"phy", "upd", "lcd", "frm"};
+
+Profiler::Profiler()
+    : overlay_visible(false),
+      phases(),
+      frames(0),
+      cursor(0),
+      physics_steps(0),
+      max_physics_steps(0),
+      dropped_frames(0),
+      dropped_time(0),
+      particle_total(0),
+      particles_now(0),
+      max_particles(0),
+      frame_start(std::chrono::steady_clock::now()),
+      overlay_refreshed(),
+      overlay_held_since(-1),
+      overlay_toggled(false) {}
+
+void Profiler::record(Phase phase, double seconds) {
+    PhaseSamples& samples = phases[(size_t)phase];
+    samples.recent[cursor] += seconds;
+    samples.max = std::max(samples.max, seconds);
+
+    double us = std::max(seconds * 1e6, 1.0);
+    int bucket = (int)(std::log2(us) * BUCKETS_PER_OCTAVE);
+    samples.histogram[std::clamp(bucket, 0, BUCKETS - 1)]++;
+}
+
+void Profiler::count_physics_steps(uint32_t steps) {
+    physics_steps += steps;
+    max_physics_steps = std::max(max_physics_steps, steps);
+}
+
+void Profiler::count_particles(size_t live) {
+    particle_total += live;
+    particles_now = live;
+    max_particles = std::max(max_particles, live);
+}
+
+void Profiler::drop_time(double seconds) {
+    dropped_frames++;
+    dropped_time += seconds;
+}
+
+void Profiler::end_frame() {
+    auto now = std::chrono::steady_clock::now();
+    record(Phase::Frame,
+           std::chrono::duration<double>(now - frame_start).count());
+    frame_start = now;
+
+    frames++;
+    cursor = frames % HISTORY;
+    for (PhaseSamples& samples : phases)
+        samples.recent[cursor] = 0;
+}
+
+Profiler::Summary Profiler::recent(Phase phase) const {
+    const PhaseSamples& samples = phases[(size_t)phase];
+    size_t n = std::min<uint64_t>(frames, HISTORY);
+    if (n == 0)
+        return {0, 0, 0, 0};
+
+    // the slot at the cursor belongs to the frame in progress
+    std::array<float, HISTORY> sorted;
+    size_t count = 0;
+    for (size_t i = 0; i < HISTORY && count < n; i++) {
+        if (i != cursor)
+            sorted[count++] = samples.recent[i];
+    }
+    std::sort(sorted.begin(), sorted.begin() + count);
+
+    auto percentile = [&](double p) {
+        return sorted[std::min((size_t)(p * count), count - 1)] * 1e3;
+    };
+    return {percentile(0.5), percentile(0.95), percentile(0.99),
+            sorted[count - 1] * 1e3};
+}
+
+Profiler::Summary Profiler::overall(Phase phase) const {
+    const PhaseSamples& samples = phases[(size_t)phase];
+    uint64_t total = 0;
+    for (uint64_t count : samples.histogram)
+        total += count;
+    if (total == 0)
+        return {0, 0, 0, 0};
+
+    // report the upper edge of the bucket each percentile falls into
+    auto percentile = [&](double p) {
+        uint64_t target = (uint64_t)std::ceil(p * total);
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += samples.histogram[i];
+            if (seen >= target)
+                return std::pow(2.0, (i + 1.0) / BUCKETS_PER_OCTAVE) / 1e3;
+        }
+        return samples.max * 1e3;
+    };
+    return {std::min(percentile(0.5), samples.max * 1e3),
+            std::min(percentile(0.95), samples.max * 1e3),
+            std::min(percentile(0.99), samples.max * 1e3), samples.max * 1e3};
+}
+
+void Profiler::render_overlay() {
+    if (!overlay_visible)
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - overlay_refreshed > std::chrono::milliseconds(500)) {
+        overlay_refreshed = now;
+
+        char line[32];
+        for (size_t i = 0; i < (size_t)Phase::Count; i++) {
+            Summary summary = recent((Phase)i);
+            std::snprintf(line, sizeof(line), "%s%5.1f%5.1f", PHASE_NAMES[i],
+                          summary.p50, summary.p99);
+            overlay_lines[i] = line;
+        }
+
+        std::snprintf(line, sizeof(line), "stp%5.2f%5u",
+                      frames ? (double)physics_steps / frames : 0.0,
+                      (unsigned)dropped_frames);
+        overlay_lines[(size_t)Phase::Count] = line;
+
+        std::snprintf(line, sizeof(line), "prt%5u%5u", (unsigned)particles_now,
+                      (unsigned)max_particles);
+        overlay_lines[(size_t)Phase::Count + 1] = line;
+    }
+
+    const int PADDING = 2;
+    int width = 13 * FONT_GLYPH_WIDTH + PADDING * 2;
+    int height = overlay_lines.size() * FONT_GLYPH_HEIGHT + PADDING * 2;
+    int x = LCD_WIDTH - width;
+    int y = LCD_HEIGHT - height;
+
+    framebuffer->set_color(0xff000000);
+    framebuffer->fill_rectangle(x, y, width, height);
+    framebuffer->set_color(0xffffff00);
+    for (size_t i = 0; i < overlay_lines.size(); i++) {
+        framebuffer->write_at(overlay_lines[i], x + PADDING,
+                              y + PADDING + i * FONT_GLYPH_HEIGHT);
+    }
+}
+
+void Profiler::toggle_overlay_on_hold(bool pressed,
+                                      int x,
+                                      int y,
+                                      double now) {
+    if (!pressed || x < (int)LCD_WIDTH - OVERLAY_CORNER ||
+        y < (int)LCD_HEIGHT - OVERLAY_CORNER) {
+        overlay_held_since = -1;
+        overlay_toggled = false;
+        return;
+    }
+
+    // toggle once per hold, however long it goes on for
+    if (overlay_held_since < 0)
+        overlay_held_since = now;
+    if (!overlay_toggled && now - overlay_held_since >= OVERLAY_HOLD) {
+        overlay_visible = !overlay_visible;
+        overlay_toggled = true;
+    }
+}
+
+void Profiler::report(std::ostream& out) const {
+    char line[128];
+    out << "phase    p50 ms   p95 ms   p99 ms   max ms\n";
+    for (size_t i = 0; i < (size_t)Phase::Count; i++) {
+        Summary summary = overall((Phase)i);
+        std::snprintf(line, sizeof(line), "%-5s %9.3f%9.3f%9.3f%9.3f\n",
+                      PHASE_NAMES[i], summary.p50, summary.p95, summary.p99,
+                      summary.max);
+        out << line;
+    }
+
+    std::snprintf(line, sizeof(line),
+                  "frames %llu, physics steps per frame %.2f (max %u), "
+                  "dropped %.3f s over %llu frames\n",
+                  (unsigned long long)frames,
+                  frames ? (double)physics_steps / frames : 0.0,
+                  max_physics_steps, dropped_time,
+                  (unsigned long long)dropped_frames);
+    out << line;
+
+    std::snprintf(line, sizeof(line), "particles per frame %.1f (max %zu)\n",
+                  frames ? (double)particle_total / frames : 0.0,
+                  max_particles);
+    out << line;
+}
+
+ScopedTimer::ScopedTimer(Phase phase)
+    : phase(phase), start(std::chrono::steady_clock::now()) {}
+
+ScopedTimer::~ScopedTimer() {
+    profiler->record(phase, std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - start)
+                                .count());
+}
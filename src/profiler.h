@@ -0,0 +1,154 @@
+#pragma once
+
+/// @file profiler.h
+/// @author Mark Bundschuh
+/// @brief Frame time instrumentation and an on-screen overlay for it
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+/// Timed parts of a frame
+enum class Phase {
+    /// Fixed timestep physics updates, however many ran this frame
+    Physics,
+    /// Updating and rendering the current scene into the framebuffer
+    Update,
+    /// Uploading the framebuffer to the LCD
+    Present,
+    /// Whole frame, from the end of the last frame to the end of this one
+    Frame,
+    /// Number of phases
+    Count,
+};
+
+/// Collects how long each phase of every frame takes
+class Profiler {
+   public:
+    /// Percentiles of a phase's duration, in milliseconds
+    struct Summary {
+        double p50, p95, p99, max;
+    };
+
+    /// Default constructor
+    Profiler();
+
+    /// Record how long a phase took this frame
+    /// @param phase phase which was timed
+    /// @param seconds duration of the phase
+    void record(Phase phase, double seconds);
+
+    /// Record the number of physics steps run this frame
+    /// @param steps number of fixed timestep updates
+    void count_physics_steps(uint32_t steps);
+
+    /// Record the number of particles drawn this frame
+    /// @param live number of particles alive
+    void count_particles(size_t live);
+
+    /// Record frame time that was thrown away because the game fell too far
+    /// behind to catch up
+    /// @param seconds time dropped from the physics accumulator
+    void drop_time(double seconds);
+
+    /// Finish a frame, recording the time since the last frame
+    void end_frame();
+
+    /// Percentiles of a phase over the last HISTORY frames
+    /// @param phase phase to summarize
+    Summary recent(Phase phase) const;
+
+    /// Percentiles of a phase over every frame so far
+    /// @param phase phase to summarize
+    Summary overall(Phase phase) const;
+
+    /// Draw the overlay into the corner of the framebuffer, if it is visible
+    void render_overlay();
+
+    /// Show or hide the overlay once the bottom right corner of the screen,
+    /// where the overlay is drawn, has been held down for OVERLAY_HOLD
+    /// seconds. Call once per frame.
+    /// @param pressed whether the screen is being touched, for a touch which
+    /// may toggle the overlay
+    /// @param x screenspace x coordinate of the touch
+    /// @param y screenspace y coordinate of the touch
+    /// @param now time of this frame in seconds
+    void toggle_overlay_on_hold(bool pressed, int x, int y, double now);
+
+    /// Write a summary of every phase and counter
+    /// @param out stream to write to
+    void report(std::ostream& out) const;
+
+    /// Whether the overlay is drawn
+    bool overlay_visible;
+
+    /// Number of frames which recent percentiles are taken from
+    static const size_t HISTORY = 256;
+    /// Size of the square in the bottom right corner which toggles the
+    /// overlay, which is inside the margin every button keeps from the edge
+    static const int OVERLAY_CORNER = 16;
+    /// Seconds the corner has to be held to toggle the overlay
+    static constexpr double OVERLAY_HOLD = 1.0;
+
+   private:
+    /// Number of histogram buckets per doubling of duration
+    static const int BUCKETS_PER_OCTAVE = 4;
+    /// Number of histogram buckets, covering 1 us to about 1 s
+    static const int BUCKETS = 20 * BUCKETS_PER_OCTAVE;
+
+    /// Samples and histogram for a single phase
+    struct PhaseSamples {
+        /// Ring buffer of the most recent durations in seconds
+        std::array<float, HISTORY> recent;
+        /// Log spaced histogram of every duration
+        std::array<uint64_t, BUCKETS> histogram;
+        double max;
+    };
+
+    std::array<PhaseSamples, (size_t)Phase::Count> phases;
+    /// Number of frames recorded
+    uint64_t frames;
+    /// Index into the ring buffers for the current frame
+    size_t cursor;
+
+    uint64_t physics_steps;
+    uint32_t max_physics_steps;
+    uint64_t dropped_frames;
+    double dropped_time;
+
+    uint64_t particle_total;
+    size_t particles_now;
+    size_t max_particles;
+
+    std::chrono::steady_clock::time_point frame_start;
+
+    /// Overlay text, refreshed a few times a second so it can be read
+    std::array<std::string, 6> overlay_lines;
+    std::chrono::steady_clock::time_point overlay_refreshed;
+    /// Time the corner started being held, or a negative number if it is not
+    double overlay_held_since;
+    /// Whether the overlay was already toggled by the current hold
+    bool overlay_toggled;
+};
+
+/// Times a phase from construction to destruction
+class ScopedTimer {
+   public:
+    /// Start timing a phase
+    /// @param phase phase to time
+    ScopedTimer(Phase phase);
+
+    /// Stop timing and record the duration with the profiler
+    ~ScopedTimer();
+
+   private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+/// Global variable to hold the frame profiler
+inline auto profiler = std::make_shared<Profiler>();
@@ -0,0 +1,145 @@
+/// @file replay.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of input recording and replaying
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "replay.h"
+
+/// Magic number at the start of every recording, including a format version
+static const char MAGIC[] = {'F', 'R', 'P', 'L', 2};
+
+/// Map a signed integer to an unsigned one so small magnitudes stay small
+/// @param value signed value
+static uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+/// Undo zigzag
+/// @param value zigzag encoded value
+static int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+Replay::Replay()
+    : current_mode(Mode::Off),
+      cursor(0),
+      frame_count(0),
+      last_x(0),
+      last_y(0) {}
+
+bool Replay::record(const std::string& path) {
+    file.open(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t seed =
+        (uint32_t)std::chrono::system_clock::now().time_since_epoch().count();
+    srand(seed);
+
+    current_mode = Mode::Recording;
+    buffer.assign(std::begin(MAGIC), std::end(MAGIC));
+    put_varint(seed);
+    flush();
+    return true;
+}
+
+bool Replay::play(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+
+    buffer.assign(std::istreambuf_iterator<char>(in),
+                  std::istreambuf_iterator<char>());
+    if (buffer.size() < sizeof(MAGIC) ||
+        !std::equal(std::begin(MAGIC), std::end(MAGIC), buffer.begin()))
+        return false;
+
+    cursor = sizeof(MAGIC);
+    uint32_t seed;
+    if (!get_varint(seed))
+        return false;
+    srand(seed);
+
+    current_mode = Mode::Playing;
+    return true;
+}
+
+void Replay::write(const ReplayFrame& frame) {
+    bool moved = frame.x != last_x || frame.y != last_y;
+    put_varint(frame.ticks << 2 | frame.pressed << 1 | moved);
+    if (moved) {
+        put_varint(zigzag(frame.x - last_x));
+        put_varint(zigzag(frame.y - last_y));
+        last_x = frame.x;
+        last_y = frame.y;
+    }
+    buffer.push_back(frame.alpha);
+    frame_count++;
+
+    // written out every frame, so that a run which is closed or crashes
+    // keeps all of its recording
+    flush();
+}
+
+bool Replay::read(ReplayFrame& frame) {
+    uint32_t header;
+    if (!get_varint(header))
+        return false;
+
+    frame.ticks = header >> 2;
+    frame.pressed = header & 2;
+    if (header & 1) {
+        uint32_t dx, dy;
+        if (!get_varint(dx) || !get_varint(dy))
+            return false;
+        last_x += unzigzag(dx);
+        last_y += unzigzag(dy);
+    }
+    frame.x = last_x;
+    frame.y = last_y;
+
+    if (cursor >= buffer.size())
+        return false;
+    frame.alpha = buffer[cursor++];
+    frame_count++;
+    return true;
+}
+
+uint8_t Replay::quantize_alpha(double alpha) {
+    return (uint8_t)std::min(std::lround(alpha * 256), 255L);
+}
+
+void Replay::flush() {
+    file.write((const char*)buffer.data(), buffer.size());
+    file.flush();
+    buffer.clear();
+}
+
+void Replay::put_varint(uint32_t value) {
+    while (value >= 0x80) {
+        buffer.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back((uint8_t)value);
+}
+
+bool Replay::get_varint(uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (cursor >= buffer.size())
+            return false;
+
+        uint8_t byte = buffer[cursor++];
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
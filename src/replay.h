@@ -0,0 +1,111 @@
+#pragma once
+
+/// @file replay.h
+/// @author Mark Bundschuh
+/// @brief Deterministic recording and replaying of input
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Input and timing of a single frame
+struct ReplayFrame {
+    /// Number of physics ticks run before the frame
+    uint32_t ticks;
+    /// Physics alpha the frame was rendered with, in 1/256ths
+    uint8_t alpha;
+    /// Whether the screen was touched
+    bool pressed;
+    /// Touch coordinates, which are kept from the last touch while the screen
+    /// is not touched
+    int x, y;
+};
+
+/// Records or replays everything that makes a run of the game differ from
+/// another: the random seed, and for every frame the physics ticks run, the
+/// alpha it was rendered with, and the touch state. Time is kept in physics
+/// ticks rather than wall time, so a replay reproduces the run exactly no
+/// matter how fast it is played back.
+///
+/// The file starts with a magic number and the seed as a varint, followed by
+/// one record per frame: a varint of the tick count shifted left twice, with
+/// whether the screen is touched and whether the touch coordinates changed in
+/// the low bits, then if they changed the zigzag varint differences of x and y
+/// from the previous frame, then the alpha byte. A frame with nothing touched
+/// and one tick is two bytes.
+class Replay {
+   public:
+    /// What the replay is doing
+    enum class Mode {
+        Off,
+        Recording,
+        Playing,
+    };
+
+    /// Default constructor, neither recording nor playing
+    Replay();
+
+    /// Start recording to a file, seeding the random number generator with a
+    /// new seed
+    /// @param path path of the file to write
+    /// @return whether the file could be opened
+    bool record(const std::string& path);
+
+    /// Load a recording and seed the random number generator with its seed
+    /// @param path path of the file to read
+    /// @return whether the file could be read and is a recording
+    bool play(const std::string& path);
+
+    /// What the replay is doing
+    Mode mode() const { return current_mode; }
+
+    /// Append a frame to the recording and write it out straight away
+    /// @param frame input and timing of the frame
+    void write(const ReplayFrame& frame);
+
+    /// Read the next frame of the recording being played
+    /// @param frame filled with the input and timing of the frame
+    /// @return false once every frame has been read
+    bool read(ReplayFrame& frame);
+
+    /// Number of frames written or read so far
+    uint64_t frames() const { return frame_count; }
+
+    /// Round a physics alpha to what can be stored in a recording
+    /// @param alpha physics alpha in [0, 1)
+    /// @return alpha in 1/256ths
+    static uint8_t quantize_alpha(double alpha);
+
+    /// Convert an alpha from a recording back to a physics alpha
+    /// @param alpha alpha in 1/256ths
+    static double alpha(uint8_t alpha) { return alpha / 256.0; }
+
+   private:
+    /// Write the encoded header or frame to the file
+    void flush();
+
+    /// Append an unsigned LEB128 varint to the buffer
+    /// @param value value to append
+    void put_varint(uint32_t value);
+
+    /// Read an unsigned LEB128 varint from the buffer
+    /// @param value filled with the value read
+    /// @return false if the buffer ran out first
+    bool get_varint(uint32_t& value);
+
+    Mode current_mode;
+    std::ofstream file;
+    /// Encoded frame waiting to be written, or the recording being read
+    std::vector<uint8_t> buffer;
+    /// Read position in buffer while playing
+    size_t cursor;
+    uint64_t frame_count;
+    /// Last touch position, which touches are stored relative to
+    int last_x, last_y;
+};
+
+/// Global variable to hold the replay recorder and player
+inline auto replay = std::make_shared<Replay>();
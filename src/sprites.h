@@ -0,0 +1,26 @@
+#pragma once
+
+/// @file sprites.h
+/// @author Mark Bundschuh
+/// @brief Identifiers of the sprites built into the game
+
+#include <cstddef>
+#include <cstdint>
+
+// SPRITES, generated from the files in assets/
+#include "build/assets/sprites.h"
+
+/// Every sprite in assets/, named after its file: assets/apple-left.png is
+/// SpriteId::AppleLeft
+enum class SpriteId : uint16_t {
+#define X(id, path, data) id,
+    SPRITES(X)
+#undef X
+};
+
+/// Number of sprites built into the game
+const size_t SPRITE_COUNT = 0
+#define X(id, path, data) +1
+    SPRITES(X)
+#undef X
+    ;
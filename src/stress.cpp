@@ -0,0 +1,167 @@
+/// @file stress.cpp
+/// @author Mark Bundschuh
+/// @brief Stress test implementation
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "FEHLCD.h"
+
+#include "config.h"
+#include "framebuffer.h"
+#include "game.h"
+#include "menu.h"
+#include "stress.h"
+#include "tasks.h"
+#include "ui.h"
+#include "util.h"
+
+Stress::Stress() : running(false), frames(0) {
+    stop_button = std::make_unique<UIButton>(
+        "Stop", UIPosition(10, 10, UIPosition::Anchor::TopRight));
+    close_button = std::make_unique<UIButton>(
+        "Close", UIPosition(30, 30, UIPosition::Anchor::BottomLeft));
+    box = std::make_unique<UIBox>(UIPosition(0, 0, UIPosition::Center),
+                                  LCD_WIDTH - 10 * 2, LCD_HEIGHT - 10 * 2);
+
+    background = image_repository->load_image("assets/background-menu.png");
+
+    stop_button->bind_on_button_up([this]() { stop("stopped"); });
+    close_button->bind_on_button_up(
+        []() { scheduler->change_scene(menu); });
+}
+
+void Stress::start() {
+    game->start(0.12, 1);
+    game->timed = false;
+    game->knife_enabled = false;
+    game->spawn_rate = config.stress_start_rate;
+
+    running = true;
+    stop_reason.clear();
+    elapsed = 0;
+    average_frame_time = 0;
+    peak_objects = 0;
+    buckets.clear();
+    frames = 0;
+}
+
+void Stress::stop(std::string reason) {
+    if (!running)
+        return;
+
+    running = false;
+    stop_reason = reason;
+
+    std::ofstream csv("stress.csv");
+    report(csv);
+    report(std::cerr);
+    game->entities.report(std::cerr);
+    game->particles.report(std::cerr);
+}
+
+void Stress::report(std::ostream& out) const {
+    out << "objects,frames,mean_ms,max_ms\n";
+    for (size_t i = 0; i < buckets.size(); i++) {
+        if (buckets[i].frames == 0)
+            continue;
+
+        char line[64];
+        std::snprintf(line, sizeof(line), "%zu,%llu,%.3f,%.3f\n",
+                      i * BUCKET_SIZE, (unsigned long long)buckets[i].frames,
+                      buckets[i].total / buckets[i].frames * 1e3,
+                      buckets[i].max * 1e3);
+        out << line;
+    }
+}
+
+void Stress::physics_update(double t, double dt) {
+    if (!running)
+        return;
+
+    elapsed += dt;
+    if (elapsed >= config.stress_duration) {
+        stop("time limit");
+        return;
+    }
+
+    // ramp the spawn rate up, pausing while at the object limit
+    game->spawn_rate = std::min(
+        config.stress_start_rate + config.stress_spawn_ramp * (float)elapsed,
+        config.stress_max_rate);
+    if (game->object_count() >= config.stress_max_objects)
+        game->spawn_rate = 0;
+
+    game->physics_update(t, dt);
+}
+
+void Stress::update(double alpha) {
+    if (!running) {
+        framebuffer->draw_background(*background);
+
+        box->update();
+        constexpr uint64_t inner_padding = 10;
+        uint64_t x = box->get_x() + inner_padding;
+        uint64_t y = box->get_y() + inner_padding;
+        std::string title = "Stress test";
+        framebuffer->set_color(WHITE);
+        framebuffer->write_at(title, x, y);
+        framebuffer->draw_horizontal_line(
+            y + FONT_GLYPH_HEIGHT + 1, x,
+            x + title.length() * FONT_GLYPH_WIDTH);
+
+        constexpr uint64_t SPACING = FONT_GLYPH_HEIGHT + 2;
+        framebuffer->write_at(stop_reason, x, y + SPACING * 2);
+        framebuffer->write_at("peak " + std::to_string(peak_objects) + " objs",
+                              x, y + SPACING * 3);
+        framebuffer->write_at(std::to_string(frames) + " frames", x,
+                              y + SPACING * 4);
+        framebuffer->write_at("saved stress.csv", x, y + SPACING * 6);
+
+        close_button->update();
+        return;
+    }
+
+    // time since the last frame, including the physics updates before this
+    auto now = std::chrono::steady_clock::now();
+    double frame_time = std::chrono::duration<double>(now - last_frame).count();
+    last_frame = now;
+
+    size_t objects = game->object_count();
+    if (frames > 0) {
+        size_t i = objects / BUCKET_SIZE;
+        if (i >= buckets.size())
+            buckets.resize(i + 1, {0, 0, 0});
+        buckets[i].frames++;
+        buckets[i].total += frame_time;
+        buckets[i].max = std::max(buckets[i].max, frame_time);
+
+        average_frame_time = frames == 1
+                                 ? frame_time
+                                 : average_frame_time * 0.9 + frame_time * 0.1;
+        if (average_frame_time <= config.stress_frame_budget)
+            peak_objects = std::max(peak_objects, objects);
+    }
+    frames++;
+
+    game->update(alpha);
+
+    framebuffer->set_color(WHITE);
+    char line[32];
+    std::snprintf(line, sizeof(line), "%zu objs", objects);
+    framebuffer->write_at(line, 15, 15);
+    std::snprintf(line, sizeof(line), "%.0f/s", game->spawn_rate);
+    framebuffer->write_at(line, 15, 15 + FONT_GLYPH_HEIGHT + 2);
+    std::snprintf(line, sizeof(line), "%.1f ms", average_frame_time * 1e3);
+    framebuffer->write_at(line, 15, 15 + (FONT_GLYPH_HEIGHT + 2) * 2);
+
+    stop_button->update();
+
+    if (average_frame_time > config.stress_frame_budget)
+        stop("over frame budget");
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+/// @file stress.h
+/// @author Mark Bundschuh
+/// @brief Scene which floods the game with objects to measure how it scales
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "image.h"
+#include "ui.h"
+#include "util.h"
+
+/// Stress test Scene. Runs an endless game without the knife, ramping up the
+/// spawn rate until the frame budget is exceeded (or a configured limit is
+/// reached), and records frame time against the number of live objects.
+/// @see Config for the limits of the stress test
+class Stress final : public Scene {
+   public:
+    /// Default constructor
+    Stress();
+
+    /// Start a new stress test
+    void start();
+
+    /// Update and render the stress test
+    /// @param alpha physics alpha, for interpolation between previous state and
+    /// next state
+    void update(double alpha);
+
+    /// Run physics calculations
+    /// @param t time since start of game
+    /// @param dt physics timestep
+    void physics_update(double t, double dt);
+
+    /// Write frame time against live object count as CSV
+    /// @param out stream to write to
+    void report(std::ostream& out) const;
+
+   private:
+    /// Frame times of every frame with a similar number of live objects
+    struct Bucket {
+        uint64_t frames;
+        double total;
+        double max;
+    };
+
+    /// Number of live objects each bucket covers
+    static const size_t BUCKET_SIZE = 50;
+
+    /// Stop the stress test and save the results to stress.csv
+    /// @param reason why it stopped, to show with the results
+    void stop(std::string reason);
+
+    bool running;
+    std::string stop_reason;
+    /// Game time since the test started
+    double elapsed;
+    /// Moving average of frame time, to stop on sustained slowness rather than
+    /// a single slow frame
+    double average_frame_time;
+    /// Most live objects seen while within the frame budget
+    size_t peak_objects;
+    std::vector<Bucket> buckets;
+    std::chrono::steady_clock::time_point last_frame;
+    uint64_t frames;
+
+    std::unique_ptr<UIButton> stop_button;
+    std::unique_ptr<UIButton> close_button;
+    std::unique_ptr<UIBox> box;
+    std::shared_ptr<Image> background;
+};
+
+/// Global variable to hold the state of the stress test
+inline auto stress = std::make_shared<Stress>();
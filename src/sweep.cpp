@@ -0,0 +1,113 @@
+/// @file sweep.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of sweep and prune
+
+#include <algorithm>
+#include <cmath>
+
+#include "sweep.h"
+
+/// Entry of SweepAndPrune::slot_entity for a slot with nothing to sweep
+static const uint32_t NONE = UINT32_MAX;
+
+void SweepAndPrune::clear() {
+    endpoints.clear();
+    std::fill(listed.begin(), listed.end(), 0);
+}
+
+void SweepAndPrune::update(const Entities& entities,
+                           const float* x,
+                           const float* y,
+                           std::vector<EntityPair>& pairs) {
+    pairs.clear();
+
+    // find which slots hold something to sweep this time
+    std::fill(slot_entity.begin(), slot_entity.end(), NONE);
+    for (size_t i = 0; i < entities.size(); i++) {
+        if (entities.type[i] == EntityType::Shard ||
+            (entities.flags[i] & ENTITY_REMOVED))
+            continue;
+
+        uint32_t slot = entities.slot[i];
+        if (slot >= slot_entity.size()) {
+            slot_entity.resize(slot + 1, NONE);
+            listed.resize(slot + 1, 0);
+            active_at.resize(slot + 1);
+        }
+        slot_entity[slot] = i;
+    }
+
+    // Drop the endpoints of whatever is gone and move the rest to where their
+    // entities are now. A slot that was reused keeps its endpoints, which are
+    // most likely nowhere near the new entity, but the sort takes care of it.
+    size_t kept = 0;
+    for (const Endpoint& endpoint : endpoints) {
+        uint32_t i = slot_entity[endpoint.slot];
+        if (i == NONE) {
+            listed[endpoint.slot] = 0;
+            continue;
+        }
+
+        Endpoint& moved = endpoints[kept++];
+        moved = endpoint;
+        float r = entities.radius[i];
+        moved.value = endpoint.end ? x[i] + r : x[i] - r;
+    }
+    endpoints.resize(kept);
+
+    for (uint32_t slot = 0; slot < slot_entity.size(); slot++) {
+        uint32_t i = slot_entity[slot];
+        if (i == NONE || listed[slot])
+            continue;
+
+        float r = entities.radius[i];
+        endpoints.push_back({x[i] - r, slot, false});
+        endpoints.push_back({x[i] + r, slot, true});
+        listed[slot] = 1;
+    }
+
+    // insertion sort, which is close to linear when little has changed order
+    for (size_t k = 1; k < endpoints.size(); k++) {
+        Endpoint endpoint = endpoints[k];
+        size_t j = k;
+        for (; j > 0 && before(endpoint, endpoints[j - 1]); j--)
+            endpoints[j] = endpoints[j - 1];
+        endpoints[j] = endpoint;
+    }
+
+    // sweep left to right, pairing each box that starts with every box still
+    // open whose y range overlaps it too
+    active_slot.clear();
+    active_entity.clear();
+    active_y.clear();
+    active_radius.clear();
+    for (const Endpoint& endpoint : endpoints) {
+        if (endpoint.end) {
+            // the last active box takes this one's place
+            uint32_t at = active_at[endpoint.slot];
+            active_slot[at] = active_slot.back();
+            active_entity[at] = active_entity.back();
+            active_y[at] = active_y.back();
+            active_radius[at] = active_radius.back();
+            active_at[active_slot[at]] = at;
+            active_slot.pop_back();
+            active_entity.pop_back();
+            active_y.pop_back();
+            active_radius.pop_back();
+            continue;
+        }
+
+        uint32_t i = slot_entity[endpoint.slot];
+        float yi = y[i];
+        float ri = entities.radius[i];
+        for (size_t k = 0; k < active_entity.size(); k++) {
+            if (std::abs(yi - active_y[k]) <= ri + active_radius[k])
+                pairs.push_back({active_entity[k], i});
+        }
+        active_at[endpoint.slot] = active_slot.size();
+        active_slot.push_back(endpoint.slot);
+        active_entity.push_back(i);
+        active_y.push_back(yi);
+        active_radius.push_back(ri);
+    }
+}
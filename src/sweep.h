@@ -0,0 +1,72 @@
+#pragma once
+
+/// @file sweep.h
+/// @author Mark Bundschuh
+/// @brief Sweep and prune for finding the fruits and bombs touching each other
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "entities.h"
+
+/// Two entities whose bounding boxes overlap, by index
+struct EntityPair {
+    uint32_t a, b;
+};
+
+/// Sweep and prune along the x axis. Every fruit and bomb has a start and an
+/// end endpoint in a list kept sorted between updates. Objects barely move in
+/// a physics step, so an insertion sort puts it back in order in close to one
+/// pass, and a sweep along it only pairs up objects whose x ranges overlap.
+class SweepAndPrune {
+   public:
+    /// Bring the endpoints up to date with every fruit and bomb, and find
+    /// every pair of them whose bounding boxes overlap. Shards and removed
+    /// entities are left out.
+    /// @param entities entities to sweep
+    /// @param x x coordinates of the centers of the entities, by index
+    /// @param y y coordinates of the centers of the entities, by index
+    /// @param pairs set to every overlapping pair, with the one whose box
+    /// starts further left first
+    void update(const Entities& entities,
+                const float* x,
+                const float* y,
+                std::vector<EntityPair>& pairs);
+
+    /// Forget every entity
+    void clear();
+
+   private:
+    /// Start or end of the x range of an entity's bounding box
+    struct Endpoint {
+        float value;
+        /// Slot of the entity, which stays the same while it is alive
+        uint32_t slot;
+        /// Whether this is the end of the range
+        bool end;
+    };
+
+    /// Whether one endpoint goes before another, with starts before ends at
+    /// the same place so touching boxes overlap
+    static bool before(const Endpoint& a, const Endpoint& b) {
+        return a.value < b.value || (a.value == b.value && !a.end && b.end);
+    }
+
+    /// Every entity's endpoints, sorted by before
+    std::vector<Endpoint> endpoints;
+
+    /// Index of the entity in each slot this update, for the slots holding one
+    /// to sweep
+    std::vector<uint32_t> slot_entity;
+    /// Whether each slot has endpoints in the list
+    std::vector<uint8_t> listed;
+
+    /// Boxes whose x ranges contain the sweep, as the slot, index, y
+    /// coordinate, and radius of each entity, packed together so the boxes
+    /// that start are checked against them without looking anything up
+    std::vector<uint32_t> active_slot, active_entity;
+    std::vector<float> active_y, active_radius;
+    /// Where each slot is among the active boxes
+    std::vector<uint32_t> active_at;
+};
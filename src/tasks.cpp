@@ -0,0 +1,29 @@
+/// @file tasks.cpp
+/// @author Mark Bundschuh
+/// @brief Implementation of the task scheduler
+
+#include <algorithm>
+
+#include "tasks.h"
+
+void Scheduler::start(std::unique_ptr<Task> task) {
+    tasks.push_back(std::move(task));
+}
+
+void Scheduler::change_scene(std::shared_ptr<Scene> scene) {
+    next_scene = std::move(scene);
+}
+
+void Scheduler::run(double now) {
+    // tasks can start more tasks, which get their first turn this frame too
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (!tasks[i]->resume(now))
+            tasks[i].reset();
+    }
+    tasks.erase(std::remove(tasks.begin(), tasks.end(), nullptr), tasks.end());
+
+    if (next_scene) {
+        current_scene = std::move(next_scene);
+        next_scene = nullptr;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/// @file tasks.h
+/// @author Mark Bundschuh
+/// @brief Cooperative tasks for effects and scene transitions which take more
+/// than one frame
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "util.h"
+
+/// Something which plays out over several frames, written top to bottom as if
+/// it could wait, and run a frame at a time by the scheduler. It is a
+/// stackless state machine in the style of a protothread: resume jumps back to
+/// wherever it last waited, so anything which needs to outlive a wait has to be
+/// a member rather than a local variable. Waiting for some time is a loop
+/// around TASK_NEXT_FRAME, which also lets the task draw every frame it waits.
+///
+/// @code
+/// bool resume(double now) override {
+///     TASK_BEGIN();
+///     start = now;
+///     while (now - start < 0.5) {
+///         draw_something(now - start);
+///         TASK_NEXT_FRAME();
+///     }
+///     draw_something_else();
+///     TASK_END();
+/// }
+/// @endcode
+class Task {
+   public:
+    /// Default virtual destructor
+    virtual ~Task() = default;
+
+    /// Run until the next wait, or the end
+    /// @param now time of this frame in seconds
+    /// @return whether there is more to run
+    virtual bool resume(double now) = 0;
+
+   protected:
+    /// Line of the wait to jump back to, or 0 to start from the beginning
+    int resume_point = 0;
+};
+
+/// Start of the body of Task::resume, which jumps to where it last waited
+#define TASK_BEGIN()              \
+    switch (this->resume_point) { \
+        case 0:
+
+/// Stop here and carry on from this point next frame
+#define TASK_NEXT_FRAME()              \
+    do {                               \
+        this->resume_point = __LINE__; \
+        return true;                   \
+        case __LINE__:;                \
+    } while (0)
+
+/// End of the body of Task::resume, after which the task is finished
+#define TASK_END() \
+    }              \
+    return false
+
+/// Runs every task once per frame, after the current scene has been updated
+/// and drawn, and changes scenes between frames
+class Scheduler {
+   public:
+    /// Run a task from this frame on
+    /// @param task task to run
+    void start(std::unique_ptr<Task> task);
+
+    /// Switch to a scene once this frame is over, so that the rest of the
+    /// frame finishes in the scene it started in
+    /// @param scene scene to switch to
+    void change_scene(std::shared_ptr<Scene> scene);
+
+    /// Resume every task, drop the ones which are finished, and then make any
+    /// scene change asked for this frame
+    /// @param now time of this frame in seconds
+    void run(double now);
+
+    /// Number of tasks which are running
+    size_t size() const { return tasks.size(); }
+
+   private:
+    std::vector<std::unique_ptr<Task>> tasks;
+    /// Scene to switch to at the end of the frame, if any
+    std::shared_ptr<Scene> next_scene;
+};
+
+/// Global variable to hold the scheduler
+inline auto scheduler = std::make_shared<Scheduler>();
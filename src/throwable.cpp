@@ -1,260 +1,284 @@
 /// @file throwable.cpp
-/// @authors Mark Bundschuh or John Ulm if stated
-/// @brief Implementation of objects with physics
+/// @author Mark Bundschuh
+/// @brief Implementation of collision detection, with AVX2 and SSE2 versions
+/// of the batch test picked at compile time and a scalar fallback for
+/// everything else
 
 #include <algorithm>
-#include <cmath>
-#include <cstdint>
-#include <iostream>
-#include <limits>
-#include <memory>
+#include <cstring>
 
-#include "FEHLCD.h"
-#include "FEHUtility.h"
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
-#include "endgame.h"
-#include "game.h"
-#include "image.h"
-#include "menu.h"
 #include "throwable.h"
-#include "ui.h"
 #include "util.h"
 
-#define PI 3.14159265358979323846
+// A segment from l1 to l2 hits a circle when the closest point on it to the
+// center is within the radius. That point is l1 + t * (l2 - l1), with t the
+// projection of the center onto the segment clamped to [0, 1], and distances
+// are compared squared so nothing needs a square root. Every version does the
+// same operations in the same order, so results do not depend on which one a
+// circle goes through.
 
-// All of the collision logic comes from this website:
-// https://www.jeffreythompson.org/collision-detection/line-circle.php
+/// Segment and its reciprocal squared length, shared by every circle tested
+/// against it
+struct Segment {
+    float x, y, dx, dy, inv_length_squared;
 
-/// Check a collision between a point and a circle with a given radius
-/// @param p point to check
-/// @param c position of center of circle
-/// @param r radius of circle
-/// @return Whether the collision did happen
-bool collide_point_circle(Vector2 p, Vector2 c, float r) {
-    float distance = Vector2::distance(p, c);
-    return distance <= r;
-}
-
-/// Check a collision between a line and a point
-/// @param l1 first endpoint of line
-/// @param l2 last endpoint of line
-/// @param p the point
-/// @return Whether the collision did happen
-bool collide_line_point(Vector2 l1, Vector2 l2, Vector2 p) {
-    // get distance from the point to the two ends of the line
-    float d1 = Vector2::distance(p, l1);
-    float d2 = Vector2::distance(p, l2);
-
-    // get the length of the line
-    float line_length = Vector2::distance(l1, l2);
+    Segment(Vector2 l1, Vector2 l2)
+        : x(l1.x), y(l1.y), dx(l2.x - l1.x), dy(l2.y - l1.y) {
+        float length_squared = dx * dx + dy * dy;
 
-    // since floats are so minutely accurate, add
-    // a little buffer zone that will give collision
-    float buffer = 0.1f;  // higher # = less accurate
+        // a segment with no length is a point, where every t is the same
+        inv_length_squared = length_squared > 0 ? 1 / length_squared : 0;
+    }
 
-    // if the two distances are equal to the line's
-    // length, the point is on the line!
-    // note we use the buffer here to give a range,
-    // rather than one #
-    return d1 + d2 >= line_length - buffer && d1 + d2 <= line_length + buffer;
-}
+    /// Whether a circle touches the segment
+    /// @param cx x coordinate of the center of the circle
+    /// @param cy y coordinate of the center of the circle
+    /// @param r radius of the circle
+    bool hits(float cx, float cy, float r) const {
+        float fx = cx - x;
+        float fy = cy - y;
+        float t = (fx * dx + fy * dy) * inv_length_squared;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        float ex = fx - t * dx;
+        float ey = fy - t * dy;
+        return ex * ex + ey * ey <= r * r;
+    }
+};
 
-/// Check a collision between a line and a circle
-/// @param l1 first endpoint of line
-/// @param l2 last endpoint of line
-/// @param p the center of the circle
-/// @param r the radius of the circle
-/// @return Whether the collision did happen
 bool collide_line_circle(Vector2 l1, Vector2 l2, Vector2 c, float r) {
-    // is either end INSIDE the circle?
-    // if so, return true immediately
-    bool inside_1 = collide_point_circle(l1, c, r);
-    if (inside_1)
-        return true;
-
-    bool inside_2 = collide_point_circle(l2, c, r);
-    if (inside_2)
-        return true;
-
-    // get the length of the line
-    float line_length = Vector2::distance(l1, l2);
-
-    // get dot product of the line and circle
-    float dot =
-        (((c.x - l1.x) * (l2.x - l1.x)) + ((c.y - l1.y) * (l2.y - l1.y))) /
-        (line_length * line_length);
-
-    // find the closest point on the line
-    float closest_x = l1.x + (dot * (l2.x - l1.x));
-    float closest_y = l1.y + (dot * (l2.y - l1.y));
-
-    // is this point actually on the line segment?
-    // if so keep going, but if not, return false
-    bool on_segment = collide_line_point(l1, l2, {closest_x, closest_y});
-    if (!on_segment)
-        return false;
-
-    // get distance to closest point
-    float distance = Vector2::distance({closest_x, closest_y}, c);
-
-    return distance <= r;
-}
-
-PhysicsObject::PhysicsObject(Vector2 pos, float mass)
-    : prev_position(pos), current_position(pos), position(pos), mass(mass) {}
-
-void PhysicsObject::update(double alpha) {
-    position = current_position * alpha + prev_position * (1.0 - alpha);
-    velocity = current_velocity * alpha + prev_velocity * (1.0 - alpha);
-    // position = current_position;
-    // velocity = current_velocity;
+    return Segment(l1, l2).hits(c.x, c.y, r);
 }
 
-void PhysicsObject::physics_update(double t, double dt) {
-    prev_position = current_position;
-    prev_velocity = current_velocity;
-
-    current_velocity += acceleration * dt;
-    current_position += current_velocity * dt;
-
-    // clear the acceleration every frame
-    acceleration = {0, 0};
-}
-
-void PhysicsObject::add_force(const Vector2& force) {
-    // Newton's 2nd law: f = m * a or a = f / m
-    acceleration += force / mass;
+/// Set the bits of the circles in a range which a segment hits, one at a time
+/// @param segment segment to test against
+/// @param x x coordinates of the centers of the circles
+/// @param y y coordinates of the centers of the circles
+/// @param r radii of the circles
+/// @param first first circle to test
+/// @param n one past the last circle to test
+/// @param hits bitmask to set the bits of hit circles in
+static void line_circles_range(const Segment& segment,
+                               const float* x,
+                               const float* y,
+                               const float* r,
+                               size_t first,
+                               size_t n,
+                               uint64_t* hits) {
+    for (size_t i = first; i < n; i++) {
+        if (segment.hits(x[i], y[i], r[i]))
+            hits[i / 64] |= (uint64_t)1 << (i % 64);
+    }
 }
 
-Fruit::Fruit(std::string image_name, float radius, Vector2 pos, float mass)
-    : PhysicsObject(pos, mass),
-      should_be_removed(false),
-      radius(radius),
-      image_name(image_name),
-      image(image_repository->load_image("assets/" + image_name + ".png")) {}
-
-void Fruit::update(double alpha) {
-    PhysicsObject::update(alpha);
-
-    if (position.y - radius > LCD_HEIGHT + 100) {
-        should_be_removed = true;
+void collide_line_circles(Vector2 l1,
+                          Vector2 l2,
+                          const float* x,
+                          const float* y,
+                          const float* r,
+                          size_t n,
+                          uint64_t* hits) {
+    Segment segment(l1, l2);
+    std::memset(hits, 0, (n + 63) / 64 * sizeof(uint64_t));
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 sx8 = _mm256_set1_ps(segment.x);
+    const __m256 sy8 = _mm256_set1_ps(segment.y);
+    const __m256 dx8 = _mm256_set1_ps(segment.dx);
+    const __m256 dy8 = _mm256_set1_ps(segment.dy);
+    const __m256 inv8 = _mm256_set1_ps(segment.inv_length_squared);
+    const __m256 zero8 = _mm256_setzero_ps();
+    const __m256 one8 = _mm256_set1_ps(1);
+    for (; i + 8 <= n; i += 8) {
+        __m256 fx = _mm256_sub_ps(_mm256_loadu_ps(x + i), sx8);
+        __m256 fy = _mm256_sub_ps(_mm256_loadu_ps(y + i), sy8);
+        __m256 t = _mm256_mul_ps(
+            _mm256_add_ps(_mm256_mul_ps(fx, dx8), _mm256_mul_ps(fy, dy8)),
+            inv8);
+        t = _mm256_min_ps(_mm256_max_ps(t, zero8), one8);
+        __m256 ex = _mm256_sub_ps(fx, _mm256_mul_ps(t, dx8));
+        __m256 ey = _mm256_sub_ps(fy, _mm256_mul_ps(t, dy8));
+        __m256 d2 =
+            _mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey));
+        __m256 r8 = _mm256_loadu_ps(r + i);
+        __m256 hit = _mm256_cmp_ps(d2, _mm256_mul_ps(r8, r8), _CMP_LE_OQ);
+        hits[i / 64] |= (uint64_t)_mm256_movemask_ps(hit) << (i % 64);
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128 sx4 = _mm_set1_ps(segment.x);
+    const __m128 sy4 = _mm_set1_ps(segment.y);
+    const __m128 dx4 = _mm_set1_ps(segment.dx);
+    const __m128 dy4 = _mm_set1_ps(segment.dy);
+    const __m128 inv4 = _mm_set1_ps(segment.inv_length_squared);
+    const __m128 zero4 = _mm_setzero_ps();
+    const __m128 one4 = _mm_set1_ps(1);
+    for (; i + 4 <= n; i += 4) {
+        __m128 fx = _mm_sub_ps(_mm_loadu_ps(x + i), sx4);
+        __m128 fy = _mm_sub_ps(_mm_loadu_ps(y + i), sy4);
+        __m128 t = _mm_mul_ps(
+            _mm_add_ps(_mm_mul_ps(fx, dx4), _mm_mul_ps(fy, dy4)), inv4);
+        t = _mm_min_ps(_mm_max_ps(t, zero4), one4);
+        __m128 ex = _mm_sub_ps(fx, _mm_mul_ps(t, dx4));
+        __m128 ey = _mm_sub_ps(fy, _mm_mul_ps(t, dy4));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+        __m128 r4 = _mm_loadu_ps(r + i);
+        __m128 hit = _mm_cmple_ps(d2, _mm_mul_ps(r4, r4));
+        hits[i / 64] |= (uint64_t)_mm_movemask_ps(hit) << (i % 64);
     }
+#endif
 
-    image->render(position.x, position.y,
-                  game->t * PI * std::clamp(velocity.x / 10.0f, -2.0f, 2.0f));
+    line_circles_range(segment, x, y, r, i, n, hits);
 }
 
-bool Fruit::get_should_be_removed() const {
-    return should_be_removed;
+void collide_line_circles_scalar(Vector2 l1,
+                                 Vector2 l2,
+                                 const float* x,
+                                 const float* y,
+                                 const float* r,
+                                 size_t n,
+                                 uint64_t* hits) {
+    std::memset(hits, 0, (n + 63) / 64 * sizeof(uint64_t));
+    line_circles_range(Segment(l1, l2), x, y, r, 0, n, hits);
 }
 
-void Fruit::physics_update(double t, double dt) {
-    // apply gravity
-    add_force({0, 3500.0f});
-
-    PhysicsObject::physics_update(t, dt);
+// Seen from the center of a circle, the point moves in a straight line from
+// where it starts relative to the circle to where it ends relative to it, so
+// the point and the circle meet when that line passes within the radius of the
+// center. The closest point is found like in Segment::hits, except that a line
+// with no length has a t of NaN, which the clamps turn into 0 the same way
+// maxps and minps do.
+
+/// Whether a moving point hits a moving circle
+/// @param sx x coordinate of where the point starts relative to the circle
+/// @param sy y coordinate of where the point starts relative to the circle
+/// @param ex x coordinate of where the point ends relative to the circle
+/// @param ey y coordinate of where the point ends relative to the circle
+/// @param r radius of the circle
+static bool swept_hits(float sx, float sy, float ex, float ey, float r) {
+    float dx = ex - sx;
+    float dy = ey - sy;
+    float t = -(sx * dx + sy * dy) / (dx * dx + dy * dy);
+    t = t > 0 ? t : 0;
+    t = t < 1 ? t : 1;
+    float hx = sx + t * dx;
+    float hy = sy + t * dy;
+    return hx * hx + hy * hy <= r * r;
 }
 
-void Fruit::collision(Vector2 p1, Vector2 p2) {
-    if (!should_be_removed && collide_line_circle(p1, p2, position, radius)) {
-        should_be_removed = true;
-
-        Vector2 force_left = {rand_range(-60000, -120000),
-                              rand_range(-120000, 120000)};
-
-        auto shard_left =
-            std::make_unique<FruitShard>("assets/" + image_name + "-left.png",
-                                         radius, position, force_left, mass);
-        game->fruit_shards.push_back(std::move(shard_left));
-
-        Vector2 force_right = {-force_left.x, -force_left.y};
-        auto shard_right =
-            std::make_unique<FruitShard>("assets/" + image_name + "-right.png",
-                                         radius, position, force_right, mass);
-        game->fruit_shards.push_back(std::move(shard_right));
-
-        game->points += game->multiplier * std::log2(game->combo + 2);
-        game->combo++;
-        game->combo_time = TimeNow();
+/// Set the bits of the circles in a range which a moving point hits, one at a
+/// time
+/// @param k1 where the point starts
+/// @param k2 where the point ends
+/// @param x1 x coordinates of where the centers of the circles start
+/// @param y1 y coordinates of where the centers of the circles start
+/// @param x2 x coordinates of where the centers of the circles end
+/// @param y2 y coordinates of where the centers of the circles end
+/// @param r radii of the circles
+/// @param first first circle to test
+/// @param n one past the last circle to test
+/// @param hits bitmask to set the bits of hit circles in
+static void swept_circles_range(Vector2 k1,
+                                Vector2 k2,
+                                const float* x1,
+                                const float* y1,
+                                const float* x2,
+                                const float* y2,
+                                const float* r,
+                                size_t first,
+                                size_t n,
+                                uint64_t* hits) {
+    for (size_t i = first; i < n; i++) {
+        if (swept_hits(k1.x - x1[i], k1.y - y1[i], k2.x - x2[i], k2.y - y2[i],
+                       r[i]))
+            hits[i / 64] |= (uint64_t)1 << (i % 64);
     }
 }
 
-Apple::Apple(Vector2 pos) : Fruit("apple", 13, pos, 8) {}
-Bananas::Bananas(Vector2 pos) : Fruit("bananas", 13, pos, 8) {}
-Orange::Orange(Vector2 pos) : Fruit("orange", 13, pos, 8) {}
-Cherries::Cherries(Vector2 pos) : Fruit("cherries", 13, pos, 8) {}
-Strawberry::Strawberry(Vector2 pos) : Fruit("strawberry", 13, pos, 8) {}
-Pineapple::Pineapple(Vector2 pos) : Fruit("pineapple", 13, pos, 8) {}
-Bomb::Bomb(Vector2 pos) : Fruit("bomb", 13, pos, 8) {}
-
-void Bomb::update(double alpha) {
-    Fruit::update(alpha);
-
-    LCD.SetFontColor(RED);
-    draw_circle(position.x, position.y, radius + 5);
-}
-
-/// @author John Ulm
-void Bomb::collision(Vector2 p1, Vector2 p2) {
-    if (collide_line_circle(p1, p2, position, radius)) {
-        LCD.SetFontColor(INDIANRED);
-        LCD.FillCircle(position.x, position.y, 10);
-
-        // explosion
-        for (int i = 3; i < 100; i += 2) {
-            LCD.SetFontColor(DARKGOLDENROD);
-            fill_circle(position.x + rand_range(-4 - i, 4 + i),
-                        position.y + rand_range(-4 - i, 4 + i),
-                        rand_range(1, i));
-            LCD.SetFontColor(RED);
-            fill_circle(position.x + rand_range(-4 - i, 4 + i),
-                        position.y + rand_range(-4 - i, 4 + i),
-                        rand_range(1, i));
-            LCD.SetFontColor(GRAY);
-            fill_circle(position.x + rand_range(-4 - i, 4 + i),
-                        position.y + rand_range(-4 - i, 4 + i),
-                        rand_range(1, i));
-            LCD.SetFontColor(FIREBRICK);
-            fill_circle(position.x + rand_range(-4 - i, 4 + i),
-                        position.y + rand_range(-4 - i, 4 + i),
-                        rand_range(1, i));
-            Sleep(0.0175);
-        }
-
-        game->end();
+void collide_swept_circles(Vector2 k1,
+                           Vector2 k2,
+                           const float* x1,
+                           const float* y1,
+                           const float* x2,
+                           const float* y2,
+                           const float* r,
+                           size_t n,
+                           uint64_t* hits) {
+    std::memset(hits, 0, (n + 63) / 64 * sizeof(uint64_t));
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 k1x8 = _mm256_set1_ps(k1.x);
+    const __m256 k1y8 = _mm256_set1_ps(k1.y);
+    const __m256 k2x8 = _mm256_set1_ps(k2.x);
+    const __m256 k2y8 = _mm256_set1_ps(k2.y);
+    const __m256 zero8 = _mm256_setzero_ps();
+    const __m256 one8 = _mm256_set1_ps(1);
+    for (; i + 8 <= n; i += 8) {
+        __m256 sx = _mm256_sub_ps(k1x8, _mm256_loadu_ps(x1 + i));
+        __m256 sy = _mm256_sub_ps(k1y8, _mm256_loadu_ps(y1 + i));
+        __m256 dx = _mm256_sub_ps(_mm256_sub_ps(k2x8, _mm256_loadu_ps(x2 + i)),
+                                  sx);
+        __m256 dy = _mm256_sub_ps(_mm256_sub_ps(k2y8, _mm256_loadu_ps(y2 + i)),
+                                  sy);
+        __m256 t = _mm256_div_ps(
+            _mm256_sub_ps(zero8, _mm256_add_ps(_mm256_mul_ps(sx, dx),
+                                               _mm256_mul_ps(sy, dy))),
+            _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+        t = _mm256_min_ps(_mm256_max_ps(t, zero8), one8);
+        __m256 hx = _mm256_add_ps(sx, _mm256_mul_ps(t, dx));
+        __m256 hy = _mm256_add_ps(sy, _mm256_mul_ps(t, dy));
+        __m256 d2 =
+            _mm256_add_ps(_mm256_mul_ps(hx, hx), _mm256_mul_ps(hy, hy));
+        __m256 r8 = _mm256_loadu_ps(r + i);
+        __m256 hit = _mm256_cmp_ps(d2, _mm256_mul_ps(r8, r8), _CMP_LE_OQ);
+        hits[i / 64] |= (uint64_t)_mm256_movemask_ps(hit) << (i % 64);
     }
-}
-
-FruitShard::FruitShard(std::string image_path,
-                       float radius,
-                       Vector2 pos,
-                       Vector2 force,
-                       float mass)
-    : PhysicsObject(pos, mass),
-      should_be_removed(false),
-      radius(radius),
-      image(image_repository->load_image(image_path)) {
-    add_force(force);
-}
-
-void FruitShard::update(double alpha) {
-    PhysicsObject::update(alpha);
-
-    if (position.y - radius > LCD_HEIGHT + 100) {
-        should_be_removed = true;
+#endif
+
+#if defined(__SSE2__)
+    const __m128 k1x4 = _mm_set1_ps(k1.x);
+    const __m128 k1y4 = _mm_set1_ps(k1.y);
+    const __m128 k2x4 = _mm_set1_ps(k2.x);
+    const __m128 k2y4 = _mm_set1_ps(k2.y);
+    const __m128 zero4 = _mm_setzero_ps();
+    const __m128 one4 = _mm_set1_ps(1);
+    for (; i + 4 <= n; i += 4) {
+        __m128 sx = _mm_sub_ps(k1x4, _mm_loadu_ps(x1 + i));
+        __m128 sy = _mm_sub_ps(k1y4, _mm_loadu_ps(y1 + i));
+        __m128 dx = _mm_sub_ps(_mm_sub_ps(k2x4, _mm_loadu_ps(x2 + i)), sx);
+        __m128 dy = _mm_sub_ps(_mm_sub_ps(k2y4, _mm_loadu_ps(y2 + i)), sy);
+        __m128 t = _mm_div_ps(
+            _mm_sub_ps(zero4,
+                       _mm_add_ps(_mm_mul_ps(sx, dx), _mm_mul_ps(sy, dy))),
+            _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        t = _mm_min_ps(_mm_max_ps(t, zero4), one4);
+        __m128 hx = _mm_add_ps(sx, _mm_mul_ps(t, dx));
+        __m128 hy = _mm_add_ps(sy, _mm_mul_ps(t, dy));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(hx, hx), _mm_mul_ps(hy, hy));
+        __m128 r4 = _mm_loadu_ps(r + i);
+        __m128 hit = _mm_cmple_ps(d2, _mm_mul_ps(r4, r4));
+        hits[i / 64] |= (uint64_t)_mm_movemask_ps(hit) << (i % 64);
     }
+#endif
 
-    image->render(position.x, position.y,
-                  game->t * PI * std::clamp(velocity.x / 10.0f, -2.0f, 2.0f));
+    swept_circles_range(k1, k2, x1, y1, x2, y2, r, i, n, hits);
 }
 
-bool FruitShard::get_should_be_removed() const {
-    return should_be_removed;
-}
-
-void FruitShard::physics_update(double t, double dt) {
-    // apply gravity
-    add_force({0, 3500.0f});
-
-    PhysicsObject::physics_update(t, dt);
+void collide_swept_circles_scalar(Vector2 k1,
+                                  Vector2 k2,
+                                  const float* x1,
+                                  const float* y1,
+                                  const float* x2,
+                                  const float* y2,
+                                  const float* r,
+                                  size_t n,
+                                  uint64_t* hits) {
+    std::memset(hits, 0, (n + 63) / 64 * sizeof(uint64_t));
+    swept_circles_range(k1, k2, x1, y1, x2, y2, r, 0, n, hits);
 }
@@ -7,6 +7,7 @@
 
 #include <FEHLCD.h>
 
+#include "framebuffer.h"
 #include "ui.h"
 #include "util.h"
 
@@ -51,8 +52,8 @@ void UIButton::update() {
     }
 
     box->update();
-    LCD.WriteAt(text.c_str(), box->get_x() + padding_x - 1,
-                box->get_y() + padding_y);
+    framebuffer->write_at(text, box->get_x() + padding_x - 1,
+                          box->get_y() + padding_y);
 }
 
 void UIButton::bind_on_button_up(std::function<void()> f) {
@@ -145,8 +146,8 @@ void UIBox::update() {
     uint64_t x = get_x();
     uint64_t y = get_y();
 
-    LCD.SetFontColor(background_color);
-    LCD.FillRectangle(x, y, width, height);
-    LCD.SetFontColor(0xffffffff);
-    LCD.DrawRectangle(x, y, width, height);
+    framebuffer->set_color(background_color);
+    framebuffer->fill_rectangle(x, y, width, height);
+    framebuffer->set_color(0xffffffff);
+    framebuffer->draw_rectangle(x, y, width, height);
 }
@@ -4,15 +4,21 @@
 
 #include <cmath>
 
-#include "FEHLCD.h"
 #include "FEHRandom.h"
 
+#include "framebuffer.h"
 #include "ui.h"
 #include "util.h"
 
 Scene::~Scene() {}
 void Scene::update(double alpha) {}
 void Scene::physics_update(double t, double dt) {}
+void Scene::physics_steps(double t, double dt, uint32_t steps) {
+    for (uint32_t i = 0; i < steps; i++) {
+        physics_update(t, dt);
+        t += dt;
+    }
+}
 
 /// @author John Ulm
 float rand_range(float lower, float upper) {
@@ -149,8 +155,7 @@ Vector2 Vector2::normalize() const {
 
 /// @author Mark Bundschuh
 void draw_pixel_in_bounds(int x, int y) {
-    if (x >= 0 && x < (int)LCD_WIDTH && y >= 0 && y < (int)LCD_HEIGHT)
-        LCD.DrawPixel(x, y);
+    framebuffer->draw_pixel(x, y);
 }
 
 /// @authors Department of Engineering Education, The Ohio State University and
@@ -195,29 +200,13 @@ void draw_circle(int x0, int y0, int r) {
 /// @authors Department of Engineering Education, The Ohio State University and
 /// John Ulm
 void draw_horizontal_line(int y, int x1, int x2) {
-    if (x2 < x1) {
-        int c = x2;
-        x2 = x1;
-        x1 = c;
-    }
-
-    for (int i = x1; i <= x2; i++) {
-        draw_pixel_in_bounds(i, y);
-    }
+    framebuffer->draw_horizontal_line(y, x1, x2);
 }
 
 /// @authors Department of Engineering Education, The Ohio State University and
 /// John Ulm
 void draw_vertical_line(int x, int y1, int y2) {
-    if (y2 < y1) {
-        int c = y2;
-        y2 = y1;
-        y1 = c;
-    }
-
-    for (int i = y1; i <= y2; i++) {
-        draw_pixel_in_bounds(x, i);
-    }
+    framebuffer->draw_vertical_line(x, y1, y2);
 }
 
 /// @authors Department of Engineering Education, The Ohio State University and
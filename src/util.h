@@ -4,6 +4,7 @@
 /// @author Mark Bundschuh
 /// @brief Global variables, definitions, and miscellaneous utilities
 
+#include <cstdint>
 #include <memory>
 
 /// Global variable for whether the screen is currently being touched
@@ -12,11 +13,15 @@ inline bool touchPressed;
 inline int touchX;
 /// Global variable for the current touched y coordinate
 inline int touchY;
+/// Global variable for the physics time the current touch was read at, which
+/// is ahead of the last physics step by the time left over after it
+inline double touchTime;
 
 // Get a random uniformly distributed random number in the inclusive range
 // [lower, upper]
 float rand_range(float lower, float upper);
 
+/// Drawing helpers which render into the framebuffer in the current color.
 /// Same as LCD.DrawPixel will ignore out of bounds pixels (does not do modulus)
 void draw_circle(int x0, int y0, int r);
 void draw_pixel_in_bounds(int x, int y);
@@ -39,6 +44,13 @@ class Scene {
     /// @param t time since start of game
     /// @param dt physics timestep
     virtual void physics_update(double t, double dt);
+
+    /// Run several physics updates back to back, which by default calls
+    /// physics_update for each one
+    /// @param t time since start of game
+    /// @param dt physics timestep
+    /// @param steps number of physics updates to run
+    virtual void physics_steps(double t, double dt, uint32_t steps);
 };
 
 /// 2 dimensional mathmatical vector